@@ -0,0 +1,676 @@
+/** @file flt16.c
+ *  @brief Implementation of the flt16.h interface
+ *  @details The single value functions work on the bits of each value
+ *  with integer operations. The SSE2 path does the same work on four
+ *  values at once: every case is computed for every value and the right
+ *  one is chosen with masks, so there are no branches. The F16C path uses
+ *  the conversion instructions, which round the same way.
+ */
+#include <string.h>
+
+#include "flt16.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__SSE2__) \
+    && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_F16C_PATH
+#endif
+
+/** the bits of a float */
+static inline uint32_t float_bits (float f)
+{
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+/** the float with the given bits */
+static inline float bits_float (uint32_t u)
+{
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+/** the bits of a double */
+static inline uint64_t double_bits (double d)
+{
+  uint64_t u;
+  memcpy(&u, &d, sizeof(u));
+  return u;
+}
+
+/** the double with the given bits */
+static inline double bits_double (uint64_t u)
+{
+  double d;
+  memcpy(&d, &u, sizeof(d));
+  return d;
+}
+
+float flt16_to_float (uint16_t h)
+{
+  uint32_t sign = (uint32_t) (h & 0x8000) << 16;
+  uint32_t exp  = (h >> 10) & 0x1F;
+  uint32_t frac = h & 0x3FF;
+
+  if (exp == 0x1F) /* infinity, or NaN made quiet */
+  {
+    return bits_float(sign | 0x7F800000 | (frac << 13) | (frac ? 0x400000 : 0));
+  }
+  if (exp == 0) /* zero or subnormal, frac * 2^-24 is exact */
+  {
+    float f = (float) frac * 0x1p-24f;
+    return sign ? -f : f;
+  }
+  return bits_float(sign | ((exp + 127 - FLT16_BIAS) << 23) | (frac << 13));
+}
+
+double flt16_to_double (uint16_t h)
+{
+  uint64_t sign = (uint64_t) (h & 0x8000) << 48;
+  uint64_t exp  = (h >> 10) & 0x1F;
+  uint64_t frac = h & 0x3FF;
+
+  if (exp == 0x1F)
+  {
+    return bits_double(sign | 0x7FF0000000000000ull | (frac << 42)
+                       | (frac ? 0x0008000000000000ull : 0));
+  }
+  if (exp == 0)
+  {
+    double d = (double) frac * 0x1p-24;
+    return sign ? -d : d;
+  }
+  return bits_double(sign | ((exp + 1023 - FLT16_BIAS) << 52) | (frac << 42));
+}
+
+/** Round m to nearest, ties to even, after dropping its low shift bits */
+static inline uint64_t round_shift (uint64_t m, int shift)
+{
+  uint64_t rest = m & ((1ull << shift) - 1);
+  uint64_t half = 1ull << (shift - 1);
+
+  m >>= shift;
+  return m + ((rest > half) || ((rest == half) && (m & 1)));
+}
+
+uint16_t float_to_flt16 (float f)
+{
+  uint32_t x    = float_bits(f);
+  uint16_t sign = (x >> 16) & 0x8000;
+
+  x &= 0x7FFFFFFF;
+  if (x > 0x7F800000) /* NaN: keep the top of the payload, make it quiet */
+  {
+    return sign | 0x7E00 | ((x >> 13) & 0x3FF);
+  }
+  if (x >= 0x477FF000) /* 65520 and up round to infinity */
+  {
+    return sign | 0x7C00;
+  }
+  if (x >= 0x38800000) /* normal: rebias, then round the 13 bits dropped */
+  {
+    /* a carry out of the fraction correctly bumps the exponent */
+    return sign | round_shift(x - ((127 - FLT16_BIAS) << 23), 13);
+  }
+  if (x < 0x33000000) /* below 2^-25 (2^-25 itself is a tie, to 0) */
+  {
+    return sign;
+  }
+  /* subnormal: the value in units of 2^-24 is m * 2^(e - 126) */
+  uint32_t e = x >> 23;
+  uint32_t m = (x & 0x7FFFFF) | 0x800000;
+  return sign | round_shift(m, 126 - e);
+}
+
+uint16_t double_to_flt16 (double d)
+{
+  uint64_t x    = double_bits(d);
+  uint16_t sign = (x >> 48) & 0x8000;
+
+  x &= 0x7FFFFFFFFFFFFFFFull;
+  if (x > 0x7FF0000000000000ull)
+  {
+    return sign | 0x7E00 | ((x >> 42) & 0x3FF);
+  }
+  if (x >= 0x40EFFE0000000000ull) /* 65520 */
+  {
+    return sign | 0x7C00;
+  }
+  if (x >= 0x3F10000000000000ull) /* 2^-14 */
+  {
+    return sign | round_shift(x - ((uint64_t) (1023 - FLT16_BIAS) << 52), 42);
+  }
+  if (x < 0x3E60000000000000ull) /* 2^-25 */
+  {
+    return sign;
+  }
+  uint64_t e = x >> 52;
+  uint64_t m = (x & 0xFFFFFFFFFFFFFull) | 0x10000000000000ull;
+  return sign | round_shift(m, 1051 - e);
+}
+
+/** Shift m right by d bits, or-ing the bits lost into bit 0 (sticky) */
+static inline uint32_t shift_sticky (uint32_t m, int d)
+{
+  if (d >= 32)
+  {
+    return m != 0;
+  }
+  return (m >> d) | ((m & ((1u << d) - 1)) != 0);
+}
+
+/** Round a significand with 3 extra low bits to nearest, ties to even, and
+ *  pack it with a sign and a biased exponent e (1 for a subnormal). A carry
+ *  out of the fraction bumps the exponent, and too big becomes infinity.
+ */
+static inline uint16_t round_pack (uint16_t sign, int e, uint32_t m)
+{
+  uint32_t rest = m & 7;
+  uint32_t bits;
+
+  m >>= 3;
+  m   += (rest > 4) || ((rest == 4) && (m & 1));
+  bits = ((uint32_t) (e - 1) << 10) + m; /* the hidden bit adds 1 to e */
+  return sign | ((bits >= FLT16_POS_INF) ? FLT16_POS_INF : bits);
+}
+
+/** true if h is a NaN */
+static inline int is_nan (uint16_t h)
+{
+  return (h & 0x7FFF) > FLT16_POS_INF;
+}
+
+uint16_t flt16_add (uint16_t a, uint16_t b)
+{
+  if (is_nan(a))
+  {
+    return a | 0x200;
+  }
+  if (is_nan(b))
+  {
+    return b | 0x200;
+  }
+  if ((a & 0x7FFF) < (b & 0x7FFF)) /* make a the larger in magnitude */
+  {
+    uint16_t t = a;
+    a = b;
+    b = t;
+  }
+  if ((a & 0x7C00) == 0x7C00) /* infinity */
+  {
+    return ((b & 0x7FFF) == FLT16_POS_INF) && ((a ^ b) & 0x8000)
+           ? FLT16_DEFAULT_NAN : a;
+  }
+
+  uint16_t sign = a & 0x8000;
+  int      ea   = (a >> 10) & 0x1F;
+  int      eb   = (b >> 10) & 0x1F;
+  uint32_t ma   = (a & 0x3FF) | (ea ? 0x400 : 0);
+  uint32_t mb   = (b & 0x3FF) | (eb ? 0x400 : 0);
+  int      e    = ea ? ea : 1;
+  uint32_t m;
+
+  /* 3 extra bits (guard, round, sticky) are enough to round correctly */
+  ma <<= 3;
+  mb   = shift_sticky(mb << 3, e - (eb ? eb : 1));
+
+  if ((a ^ b) & 0x8000)
+  {
+    m = ma - mb;
+    if (m == 0) /* x + -x is +0 */
+    {
+      return FLT16_POS_ZERO;
+    }
+    while ((m < (0x400 << 3)) && (e > 1))
+    {
+      m <<= 1;
+      e--;
+    }
+  }
+  else
+  {
+    m = ma + mb;
+    if (m >= (0x800 << 3))
+    {
+      m = shift_sticky(m, 1);
+      e++;
+    }
+  }
+  return round_pack(sign, e, m);
+}
+
+uint16_t flt16_sub (uint16_t a, uint16_t b)
+{
+  /* a NaN is passed on as it is, not negated */
+  return flt16_add(a, is_nan(b) ? b : (b ^ 0x8000));
+}
+
+uint16_t flt16_mul (uint16_t a, uint16_t b)
+{
+  uint16_t sign = (a ^ b) & 0x8000;
+
+  if (is_nan(a))
+  {
+    return a | 0x200;
+  }
+  if (is_nan(b))
+  {
+    return b | 0x200;
+  }
+  if (((a & 0x7C00) == 0x7C00) || ((b & 0x7C00) == 0x7C00))
+  {
+    return (((a & 0x7FFF) == 0) || ((b & 0x7FFF) == 0))
+           ? FLT16_DEFAULT_NAN : (sign | FLT16_POS_INF);
+  }
+  if (((a & 0x7FFF) == 0) || ((b & 0x7FFF) == 0))
+  {
+    return sign;
+  }
+
+  int      ea = (a >> 10) & 0x1F;
+  int      eb = (b >> 10) & 0x1F;
+  uint32_t ma = (a & 0x3FF) | (ea ? 0x400 : 0);
+  uint32_t mb = (b & 0x3FF) | (eb ? 0x400 : 0);
+
+  /* normalize subnormals, so the exponents may drop below 1 */
+  ea = ea ? ea : 1;
+  eb = eb ? eb : 1;
+  for (; ma < 0x400; ea--)
+  {
+    ma <<= 1;
+  }
+  for (; mb < 0x400; eb--)
+  {
+    mb <<= 1;
+  }
+
+  /* the product has 21 or 22 bits, keep 11 plus 3 extra */
+  uint32_t p = ma * mb;
+  int      e = ea + eb - FLT16_BIAS;
+  uint32_t m;
+
+  if (p >= (1u << 21))
+  {
+    m = shift_sticky(p, 8);
+    e++;
+  }
+  else
+  {
+    m = shift_sticky(p, 7);
+  }
+
+  if (e < 1) /* subnormal */
+  {
+    m = shift_sticky(m, 1 - e);
+    e = 1;
+  }
+  return round_pack(sign, e, m);
+}
+
+#if defined(__SSE2__)
+/** flt16_to_float() of the low 16 bits of each of 4 lanes */
+static inline __m128 sse2_to_float (__m128i h)
+{
+  __m128i mag   = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+  __m128i o     = _mm_slli_epi32(mag, 13);
+  __m128i exp   = _mm_and_si128(o, _mm_set1_epi32(0x0F800000));
+  __m128i rebias = _mm_set1_epi32((127 - FLT16_BIAS) << 23);
+
+  o = _mm_add_epi32(o, rebias);
+
+  /* infinity and NaN: rebias again, to an exponent of 255 */
+  __m128i isInfNaN = _mm_cmpeq_epi32(exp, _mm_set1_epi32(0x0F800000));
+  o = _mm_add_epi32(o, _mm_and_si128(isInfNaN, rebias));
+  __m128i isNaN = _mm_cmpgt_epi32(mag, _mm_set1_epi32(0x7C00));
+  o = _mm_or_si128(o, _mm_and_si128(isNaN, _mm_set1_epi32(0x400000)));
+
+  /* subnormal: as a normal with exponent 1 less 2^-14, which is exact */
+  __m128i isSub = _mm_cmpeq_epi32(exp, _mm_setzero_si128());
+  __m128  sub   = _mm_sub_ps(
+    _mm_castsi128_ps(_mm_add_epi32(o, _mm_set1_epi32(1 << 23))),
+    _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+  o = _mm_or_si128(_mm_andnot_si128(isSub, o),
+                   _mm_and_si128(isSub, _mm_castps_si128(sub)));
+
+  __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+  return _mm_castsi128_ps(_mm_or_si128(o, sign));
+}
+
+/** float_to_flt16() of 4 floats, the results in the low 16 bits of each
+ *  lane
+ */
+static inline __m128i sse2_from_float (__m128 f)
+{
+  __m128i x    = _mm_castps_si128(f);
+  __m128i sign = _mm_and_si128(x, _mm_set1_epi32(0x80000000));
+
+  x = _mm_xor_si128(x, sign);
+
+  /* normal: rebias, add just under half, plus 1 if the result is odd */
+  __m128i odd  = _mm_and_si128(_mm_srli_epi32(x, 13), _mm_set1_epi32(1));
+  __m128i norm = _mm_add_epi32(x, _mm_set1_epi32(0xFFF
+                                                 - ((127 - FLT16_BIAS) << 23)));
+  norm = _mm_srli_epi32(_mm_add_epi32(norm, odd), 13);
+
+  /* subnormal: adding 0.5 rounds the value to a multiple of 2^-24 */
+  __m128i half = _mm_set1_epi32(126 << 23);
+  __m128i sub  = _mm_sub_epi32(
+    _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(x), _mm_castsi128_ps(half))),
+    half);
+
+  /* 65536 and up: infinity, or NaN made quiet */
+  __m128i isNaN = _mm_cmpgt_epi32(x, _mm_set1_epi32(0x7F800000));
+  __m128i big   = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(isNaN,
+    _mm_or_si128(_mm_set1_epi32(0x200),
+                 _mm_and_si128(_mm_srli_epi32(x, 13), _mm_set1_epi32(0x3FF)))));
+
+  __m128i isBig = _mm_cmpgt_epi32(x, _mm_set1_epi32((143 << 23) - 1));
+  __m128i isSub = _mm_cmplt_epi32(x, _mm_set1_epi32(113 << 23));
+  __m128i o     = _mm_or_si128(_mm_and_si128(isSub, sub),
+                               _mm_andnot_si128(isSub, norm));
+  o = _mm_or_si128(_mm_and_si128(isBig, big), _mm_andnot_si128(isBig, o));
+  return _mm_or_si128(o, _mm_srli_epi32(sign, 16));
+}
+
+/** pack the low 16 bits of each lane of lo and hi into 8 values */
+static inline __m128i sse2_pack (__m128i lo, __m128i hi)
+{
+  /* sign extend so the saturating pack does not change anything */
+  lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+  hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+  return _mm_packs_epi32(lo, hi);
+}
+
+static size_t sse2_to_floats (const uint16_t* src, float* dst, size_t count)
+{
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128i h = _mm_loadu_si128((const __m128i*) (src + i));
+    __m128i z = _mm_setzero_si128();
+    _mm_storeu_ps(dst + i,     sse2_to_float(_mm_unpacklo_epi16(h, z)));
+    _mm_storeu_ps(dst + i + 4, sse2_to_float(_mm_unpackhi_epi16(h, z)));
+  }
+  return i;
+}
+
+static size_t sse2_from_floats (const float* src, uint16_t* dst, size_t count)
+{
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128i lo = sse2_from_float(_mm_loadu_ps(src + i));
+    __m128i hi = sse2_from_float(_mm_loadu_ps(src + i + 4));
+    _mm_storeu_si128((__m128i*) (dst + i), sse2_pack(lo, hi));
+  }
+  return i;
+}
+
+static size_t sse2_to_doubles (const uint16_t* src, double* dst, size_t count)
+{
+  size_t i = 0;
+
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i h = _mm_loadl_epi64((const __m128i*) (src + i));
+    __m128  f = sse2_to_float(_mm_unpacklo_epi16(h, _mm_setzero_si128()));
+    _mm_storeu_pd(dst + i,     _mm_cvtps_pd(f));
+    _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+  }
+  return i;
+}
+
+/** Apply the NaN rules of flt16_add() to 8 results. Which NaN the
+ *  processor passes on depends on the order of the operands of an add or
+ *  multiply, and the compiler is free to swap them.
+ */
+static inline __m128i sse2_fix_nans (__m128i a, __m128i b, __m128i r)
+{
+  __m128i inf   = _mm_set1_epi16(0x7C00);
+  __m128i mag   = _mm_set1_epi16(0x7FFF);
+  __m128i quiet = _mm_set1_epi16(0x200);
+  __m128i aNaN  = _mm_cmpgt_epi16(_mm_and_si128(a, mag), inf);
+  __m128i bNaN  = _mm_cmpgt_epi16(_mm_and_si128(b, mag), inf);
+
+  r = _mm_or_si128(_mm_andnot_si128(bNaN, r),
+                   _mm_and_si128(bNaN, _mm_or_si128(b, quiet)));
+  return _mm_or_si128(_mm_andnot_si128(aNaN, r),
+                      _mm_and_si128(aNaN, _mm_or_si128(a, quiet)));
+}
+
+/** a op b for 4 floats */
+static inline __m128 sse2_op (flt16_op_t op, __m128 a, __m128 b)
+{
+  switch (op)
+  {
+    case FLT16_ADD: return _mm_add_ps(a, b);
+    case FLT16_SUB: return _mm_sub_ps(a, b);
+    default:        return _mm_mul_ps(a, b);
+  }
+}
+
+/** a op b for 8 values at a time, in float: converting both to float is
+ *  exact, and a float holds more than twice the bits of a half, so rounding
+ *  the float result to half gives the correctly rounded half result.
+ */
+static size_t sse2_arith (flt16_op_t op, const uint16_t* a, const uint16_t* b,
+                          uint16_t* dst, size_t count)
+{
+  __m128i z = _mm_setzero_si128();
+  size_t  i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128i ha = _mm_loadu_si128((const __m128i*) (a + i));
+    __m128i hb = _mm_loadu_si128((const __m128i*) (b + i));
+    __m128  lo = sse2_op(op, sse2_to_float(_mm_unpacklo_epi16(ha, z)),
+                         sse2_to_float(_mm_unpacklo_epi16(hb, z)));
+    __m128  hi = sse2_op(op, sse2_to_float(_mm_unpackhi_epi16(ha, z)),
+                         sse2_to_float(_mm_unpackhi_epi16(hb, z)));
+    __m128i r  = sse2_pack(sse2_from_float(lo), sse2_from_float(hi));
+    _mm_storeu_si128((__m128i*) (dst + i), sse2_fix_nans(ha, hb, r));
+  }
+  return i;
+}
+#endif
+
+#if defined(HAVE_F16C_PATH)
+__attribute__((target("avx,f16c")))
+static size_t f16c_to_floats (const uint16_t* src, float* dst, size_t count)
+{
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128i h = _mm_loadu_si128((const __m128i*) (src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+  return i;
+}
+
+__attribute__((target("avx,f16c")))
+static size_t f16c_from_floats (const float* src, uint16_t* dst, size_t count)
+{
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i*) (dst + i), h);
+  }
+  return i;
+}
+
+__attribute__((target("avx,f16c")))
+static size_t f16c_to_doubles (const uint16_t* src, double* dst, size_t count)
+{
+  size_t i = 0;
+
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 f = _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*) (src + i)));
+    _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(f));
+  }
+  return i;
+}
+
+/** sse2_arith() with the conversion instructions */
+__attribute__((target("avx,f16c")))
+static size_t f16c_arith (flt16_op_t op, const uint16_t* a, const uint16_t* b,
+                          uint16_t* dst, size_t count)
+{
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128i ha = _mm_loadu_si128((const __m128i*) (a + i));
+    __m128i hb = _mm_loadu_si128((const __m128i*) (b + i));
+    __m256  fa = _mm256_cvtph_ps(ha);
+    __m256  fb = _mm256_cvtph_ps(hb);
+    __m256  r  = (op == FLT16_ADD) ? _mm256_add_ps(fa, fb)
+               : (op == FLT16_SUB) ? _mm256_sub_ps(fa, fb)
+               :                     _mm256_mul_ps(fa, fb);
+    __m128i h  = _mm256_cvtps_ph(r, _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i*) (dst + i), sse2_fix_nans(ha, hb, h));
+  }
+  return i;
+}
+#endif
+
+/** the path chosen with flt16_use_path(), -1 for the best one */
+static int chosen_path = -1;
+
+/** the fastest path this processor supports */
+static flt16_path_t best_path (void)
+{
+#if defined(HAVE_F16C_PATH)
+  if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c"))
+  {
+    return FLT16_F16C;
+  }
+#endif
+#if defined(__SSE2__)
+  return FLT16_SSE2;
+#else
+  return FLT16_SCALAR;
+#endif
+}
+
+flt16_path_t flt16_use_path (flt16_path_t path)
+{
+  flt16_path_t best = best_path();
+
+  chosen_path = (path > best) ? best : path;
+  return chosen_path;
+}
+
+/** the path to use now */
+static inline flt16_path_t current_path (void)
+{
+  return (chosen_path < 0) ? best_path() : (flt16_path_t) chosen_path;
+}
+
+void flt16s_to_floats (const uint16_t* src, float* dst, size_t count)
+{
+  size_t i = 0;
+
+  switch (current_path())
+  {
+#if defined(HAVE_F16C_PATH)
+    case FLT16_F16C:   i = f16c_to_floats(src, dst, count); break;
+#endif
+#if defined(__SSE2__)
+    case FLT16_SSE2:   i = sse2_to_floats(src, dst, count); break;
+#endif
+    default:           break;
+  }
+
+  for (; i < count; i++)
+  {
+    dst[i] = flt16_to_float(src[i]);
+  }
+}
+
+void floats_to_flt16s (const float* src, uint16_t* dst, size_t count)
+{
+  size_t i = 0;
+
+  switch (current_path())
+  {
+#if defined(HAVE_F16C_PATH)
+    case FLT16_F16C:   i = f16c_from_floats(src, dst, count); break;
+#endif
+#if defined(__SSE2__)
+    case FLT16_SSE2:   i = sse2_from_floats(src, dst, count); break;
+#endif
+    default:           break;
+  }
+
+  for (; i < count; i++)
+  {
+    dst[i] = float_to_flt16(src[i]);
+  }
+}
+
+void flt16s_to_doubles (const uint16_t* src, double* dst, size_t count)
+{
+  size_t i = 0;
+
+  switch (current_path())
+  {
+#if defined(HAVE_F16C_PATH)
+    case FLT16_F16C:   i = f16c_to_doubles(src, dst, count); break;
+#endif
+#if defined(__SSE2__)
+    case FLT16_SSE2:   i = sse2_to_doubles(src, dst, count); break;
+#endif
+    default:           break;
+  }
+
+  for (; i < count; i++)
+  {
+    dst[i] = flt16_to_double(src[i]);
+  }
+}
+
+void doubles_to_flt16s (const double* src, uint16_t* dst, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    dst[i] = double_to_flt16(src[i]);
+  }
+}
+
+void flt16s_arith (flt16_op_t op, const uint16_t* a, const uint16_t* b,
+                   uint16_t* dst, size_t count)
+{
+  size_t i = 0;
+
+  switch (current_path())
+  {
+#if defined(HAVE_F16C_PATH)
+    case FLT16_F16C:   i = f16c_arith(op, a, b, dst, count); break;
+#endif
+#if defined(__SSE2__)
+    case FLT16_SSE2:   i = sse2_arith(op, a, b, dst, count); break;
+#endif
+    default:           break;
+  }
+
+  uint16_t (*scalar) (uint16_t, uint16_t) = (op == FLT16_ADD) ? flt16_add
+                                          : (op == FLT16_SUB) ? flt16_sub
+                                          :                     flt16_mul;
+  for (; i < count; i++)
+  {
+    dst[i] = scalar(a[i], b[i]);
+  }
+}
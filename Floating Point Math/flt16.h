@@ -0,0 +1,175 @@
+#ifndef __FLT16_H__
+#define __FLT16_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @file flt16.h
+ *  @brief Defines interface of flt16.c functions
+ *  @details A half precision value is held in the low 16 bits of a
+ *  <code>uint16_t</code>, with the layout described in field.h:
+ *  <pre><code>
+ *     bit   15      14..10     9..0
+ *           sign    exponent   fraction
+ *  </code></pre>
+ *  The exponent is biased by 15. An exponent of 0 means zero or a
+ *  subnormal number (fraction * 2<sup>-24</sup>) and an exponent of 31
+ *  means infinity (fraction 0) or NaN.
+ *  <p>
+ *  Every conversion to half precision rounds to nearest, ties to even;
+ *  values too large for half precision become infinity. A NaN keeps its
+ *  sign and the high bits of its payload and is always returned quiet.
+ *  <p>
+ *  Addition, subtraction and multiplication are done in software by the
+ *  single value functions, which are the reference, and in bulk by
+ *  <code>flt16s_arith()</code>.
+ *  <p>
+ *  The bulk functions give the same results as the single value functions,
+ *  bit for bit. They use F16C instructions when the processor has them, otherwise SSE2
+ *  integer operations, otherwise plain C.
+ */
+
+/** bit position of the sign of a half precision value */
+#define FLT16_SIGN_BIT   15
+/** bit positions of the exponent of a half precision value */
+#define FLT16_EXP_HI     14
+#define FLT16_EXP_LO     10
+/** bit positions of the fraction of a half precision value */
+#define FLT16_FRAC_HI     9
+#define FLT16_FRAC_LO     0
+/** exponent bias of a half precision value */
+#define FLT16_BIAS       15
+
+/** some half precision values */
+#define FLT16_POS_ZERO   0x0000
+#define FLT16_NEG_ZERO   0x8000
+#define FLT16_POS_INF    0x7C00
+#define FLT16_NEG_INF    0xFC00
+#define FLT16_QNAN       0x7E00
+#define FLT16_MAX        0x7BFF /**< 65504 */
+/** the NaN an invalid operation (such as infinity - infinity) makes; it is
+ *  the one x86 processors make, so every path gives the same bits
+ */
+#define FLT16_DEFAULT_NAN 0xFE00
+
+/** the ways the bulk functions can do their work */
+typedef enum flt16_path {
+  FLT16_SCALAR, /**< one value at a time, in C          */
+  FLT16_SSE2,   /**< integer operations on 4 values     */
+  FLT16_F16C    /**< conversion instructions, 8 values  */
+} flt16_path_t;
+
+/** Convert a half precision value to a float (always exact)
+ *  @param h - the half precision value
+ *  @return the value as a float
+ */
+float flt16_to_float (uint16_t h);
+
+/** Convert a half precision value to a double (always exact)
+ *  @param h - the half precision value
+ *  @return the value as a double
+ */
+double flt16_to_double (uint16_t h);
+
+/** Convert a float to the nearest half precision value
+ *  @param f - the value to convert
+ *  @return the half precision value
+ */
+uint16_t float_to_flt16 (float f);
+
+/** Convert a double to the nearest half precision value. The double is
+ *  rounded once, so the result may differ from
+ *  <code>float_to_flt16((float) d)</code>.
+ *  @param d - the value to convert
+ *  @return the half precision value
+ */
+uint16_t double_to_flt16 (double d);
+
+/** Convert an array of half precision values to floats
+ *  @param src - the half precision values
+ *  @param dst - where the floats are stored
+ *  @param count - the number of values
+ */
+void flt16s_to_floats (const uint16_t* src, float* dst, size_t count);
+
+/** Convert an array of floats to half precision values
+ *  @param src - the floats
+ *  @param dst - where the half precision values are stored
+ *  @param count - the number of values
+ */
+void floats_to_flt16s (const float* src, uint16_t* dst, size_t count);
+
+/** Convert an array of half precision values to doubles
+ *  @param src - the half precision values
+ *  @param dst - where the doubles are stored
+ *  @param count - the number of values
+ */
+void flt16s_to_doubles (const uint16_t* src, double* dst, size_t count);
+
+/** Convert an array of doubles to half precision values. Each double is
+ *  rounded once, so there is no vector path: a double must not pass
+ *  through a float on its way.
+ *  @param src - the doubles
+ *  @param dst - where the half precision values are stored
+ *  @param count - the number of values
+ */
+void doubles_to_flt16s (const double* src, uint16_t* dst, size_t count);
+
+/** the arithmetic operations of <code>flt16s_arith()</code> */
+typedef enum flt16_op {
+  FLT16_ADD,
+  FLT16_SUB,
+  FLT16_MUL
+} flt16_op_t;
+
+/** Add two half precision values, rounding to nearest, ties to even. This
+ *  is the reference: it works on the sign, exponent and fraction fields
+ *  with integer operations, as the floating point assignment does, and
+ *  handles subnormals, infinities, NaNs and signed zeros. If a is a NaN
+ *  the result is a made quiet, otherwise if b is a NaN the result is b made
+ *  quiet; infinity - infinity is FLT16_DEFAULT_NAN. x + -x is +0.
+ *  @param a - the first value
+ *  @param b - the second value
+ *  @return a + b
+ */
+uint16_t flt16_add (uint16_t a, uint16_t b);
+
+/** Subtract two half precision values, as <code>flt16_add(a, -b)</code>
+ *  (a NaN in b is passed on without changing its sign)
+ *  @param a - the first value
+ *  @param b - the second value
+ *  @return a - b
+ */
+uint16_t flt16_sub (uint16_t a, uint16_t b);
+
+/** Multiply two half precision values, rounding to nearest, ties to even.
+ *  NaNs are handled as in <code>flt16_add()</code>; infinity * 0 is
+ *  FLT16_DEFAULT_NAN.
+ *  @param a - the first value
+ *  @param b - the second value
+ *  @return a * b
+ */
+uint16_t flt16_mul (uint16_t a, uint16_t b);
+
+/** Compute <code>dst[i] = a[i] op b[i]</code> for arrays of half precision
+ *  values. The vector paths compute in float, which gives exactly the
+ *  results of <code>flt16_add()</code>, <code>flt16_sub()</code> and
+ *  <code>flt16_mul()</code> (the scalar path uses them).
+ *  @param op - the operation
+ *  @param a - the first values
+ *  @param b - the second values
+ *  @param dst - where the results are stored (may be a or b)
+ *  @param count - the number of values
+ */
+void flt16s_arith (flt16_op_t op, const uint16_t* a, const uint16_t* b,
+                   uint16_t* dst, size_t count);
+
+/** Choose how the bulk functions work, for testing and timing. The
+ *  fastest path the processor supports is used until this is called.
+ *  @param path - the path wanted
+ *  @return the path that will be used: the one wanted, or the best one
+ *  available if the processor does not support it
+ */
+flt16_path_t flt16_use_path (flt16_path_t path);
+
+#endif
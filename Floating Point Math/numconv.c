@@ -5,16 +5,70 @@
 /** @todo implement in <code>numconv.c</code> based on documentation contained 
  *  in <code>numconv.h</code>.
  */
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
-int origR = 0;
+#include <stdlib.h>
+#include <string.h>
+
+#include "numconv.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/** marks a character that is not a digit in any radix */
+#define XX 0xFF
+
+/** the digit for each value */
+static const char digit_chars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+/** the value of each character as a digit ('0'-'9', 'A'-'Z', 'a'-'z'), or
+ *  XX. A digit is legal in a radix when its value is less than the
+ *  radix, so one table serves every radix.
+ */
+static const unsigned char digit_values[256] = {
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,  /* x00 */
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,  /* x10 */
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,  /* x20 */
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  9, XX, XX, XX, XX, XX, XX,  /* x30 */
+  XX, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,  /* x40 */
+  25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, XX, XX, XX, XX, XX,  /* x50 */
+  XX, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,  /* x60 */
+  25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, XX, XX, XX, XX, XX,  /* x70 */
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,  /* x80 */
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,  /* x90 */
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,  /* xA0 */
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,  /* xB0 */
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,  /* xC0 */
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,  /* xD0 */
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,  /* xE0 */
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX   /* xF0 */
+};
+
+/** "00" to "99", so decimal numbers are converted two digits at a time */
+static const char decimal_pairs[] =
+  "0001020304050607080910111213141516171819202122232425262728293031"
+  "3233343536373839404142434445464748495051525354555657585960616263"
+  "6465666768697071727374757677787980818283848586878889909192939495"
+  "96979899";
+
+/** "00" to "FF", so hex numbers are converted two digits at a time */
+static const char hex_pairs[] =
+  "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+  "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+  "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+  "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+  "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+  "A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+  "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+  "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
 char int2char (int radix, int value) {
   if (radix > 36 || radix < 2 || value >= radix || value < 0){
     return '?'; }
-  if (value < 10){
-    return (char) (value + 48); }
-  if (value >= 10){
-    return (char) (value + 55); }
-  return '?';
+  return digit_chars[value];
 } 
 
 /** @todo implement in <code>numconv.c</code> based on documentation contained 
@@ -27,46 +81,114 @@ int char2int (int radix, char digit)
     return -1;
   }
 
-  int dig = (int) digit;
-  int rdig = (int) digit;
+  int rdig = digit_values[(unsigned char) digit];
+  return (rdig < radix) ? rdig : -1;
+}
 
-  if ((dig < 58) && (dig > 47))
+int digits2values (int radix, const char* digits, int len,
+                   unsigned char* values)
+{
+  int i = 0;
+
+  if (radix > 36 || radix < 2)
   {
-   rdig = rdig - 48;
-   if (rdig < radix)
-   {
-     return rdig;
-   } 
+    return 0;
   }
 
-  if ((dig > 64) && (dig < 91))
+#if defined(__SSE2__)
+  /* 16 characters at a time: a digit is c - '0' < 10, a letter is
+     (c | 0x20) - 'a' < 26; unsigned compares are done with min */
+  const __m128i zero    = _mm_set1_epi8('0');
+  const __m128i lowA    = _mm_set1_epi8('a');
+  const __m128i caseBit = _mm_set1_epi8(0x20);
+  const __m128i nine    = _mm_set1_epi8(9);
+  const __m128i ten     = _mm_set1_epi8(10);
+  const __m128i max25   = _mm_set1_epi8(25);
+  const __m128i maxVal  = _mm_set1_epi8(radix - 1);
+
+  for (; i + 16 <= len; i += 16)
   {
-   rdig = rdig - 55;
-   if (rdig < radix) 
-   {
-     return rdig;
-   }
+    __m128i c   = _mm_loadu_si128((const __m128i*) (digits + i));
+    __m128i d   = _mm_sub_epi8(c, zero);
+    __m128i l   = _mm_sub_epi8(_mm_or_si128(c, caseBit), lowA);
+    __m128i isD = _mm_cmpeq_epi8(_mm_min_epu8(d, nine), d);
+    __m128i isL = _mm_cmpeq_epi8(_mm_min_epu8(l, max25), l);
+    __m128i val = _mm_or_si128(_mm_and_si128(isD, d),
+                               _mm_and_si128(isL, _mm_add_epi8(l, ten)));
+    __m128i ok  = _mm_and_si128(_mm_or_si128(isD, isL),
+                      _mm_cmpeq_epi8(_mm_min_epu8(val, maxVal), val));
+    int     mask = _mm_movemask_epi8(ok);
+
+    if (mask != 0xFFFF)
+    {
+      break; /* the scalar loop stores the valid prefix and stops */
+    }
+    _mm_storeu_si128((__m128i*) (values + i), val);
   }
+#endif
 
-  if ((dig > 96) && (dig < 123))
+  for (; i < len; i++)
   {
-   rdig = rdig - 87;
-   if (rdig < radix) 
-   {
-     return rdig;
-   }
+    unsigned char v = digit_values[(unsigned char) digits[i]];
+    if (v >= radix)
+    {
+      break;
+    }
+    values[i] = v;
   }
-
-  return -1;
+  return i;
 }
 
 /** @todo implement in <code>numconv.c</code> based on documentation contained 
  *  in <code>numconv.h</code>.
  */
+#if defined(__SIZEOF_INT128__)
+/** 2^64 / d rounded up. For a 32 bit n, the high 64 bits of n * M are
+ *  n / d, and the low 64 bits multiplied by d give n % d in their high bits
+ *  (Lemire, Kaser and Kurz, "Faster remainder by direct computation").
+ */
+#define MAGIC(d) (UINT64_MAX / (d) + 1)
+
+/** the reciprocal of each radix, indexed by radix (0 and 1 unused) */
+static const uint64_t radix_magic[37] = {
+  0,          0,          MAGIC(2),   MAGIC(3),   MAGIC(4),   MAGIC(5),
+  MAGIC(6),   MAGIC(7),   MAGIC(8),   MAGIC(9),   MAGIC(10),  MAGIC(11),
+  MAGIC(12),  MAGIC(13),  MAGIC(14),  MAGIC(15),  MAGIC(16),  MAGIC(17),
+  MAGIC(18),  MAGIC(19),  MAGIC(20),  MAGIC(21),  MAGIC(22),  MAGIC(23),
+  MAGIC(24),  MAGIC(25),  MAGIC(26),  MAGIC(27),  MAGIC(28),  MAGIC(29),
+  MAGIC(30),  MAGIC(31),  MAGIC(32),  MAGIC(33),  MAGIC(34),  MAGIC(35),
+  MAGIC(36)
+};
+#endif
+
+/** Divide by a radix (2-36) with a multiplication instead of a divide
+ *  instruction
+ *  @return the quotient; the remainder is stored in *rem
+ */
+static inline unsigned radix_div (unsigned n, unsigned radix, unsigned* rem)
+{
+#if defined(__SIZEOF_INT128__)
+  uint64_t low = radix_magic[radix] * n;
+
+  *rem = (unsigned) (((unsigned __int128) low * radix) >> 64);
+  return (unsigned) (((unsigned __int128) radix_magic[radix] * n) >> 64);
+#else
+  *rem = n % radix;
+  return n / radix;
+#endif
+}
+
 void divRem (int numerator, int divisor, int* quotient, int* remainder) 
 {
- *quotient = numerator / divisor;
- *remainder = numerator % divisor;
+  if (numerator >= 0 && divisor >= 2 && divisor <= 36)
+  {
+    unsigned rem;
+    *quotient  = (int) radix_div(numerator, divisor, &rem);
+    *remainder = (int) rem;
+    return;
+  }
+  *quotient  = numerator / divisor;
+  *remainder = numerator % divisor;
 }
 
 /** @todo implement in <code>numconv.c</code> based on documentation contained 
@@ -77,16 +199,14 @@ int ascii2int (int radix, int valueOfPrefix) {
   {
     return -1;
   }
-  char n = getchar();
-  if (n != '\n')
+  int n = getchar();
+  if (n != '\n' && n != EOF)
   {
-    int newChar;
-    if (n < 58 && n > 47)
-      newChar = (int)n - 48;
-    if (n < 91 && n > 64)
-      newChar = (int)n - 55;
-    if (n < 123 && n > 96)
-      newChar = (int)n - 87;
+    int newChar = digit_values[n & 0xFF];
+    if (newChar >= radix) /* not a digit: the number ends here */
+    {
+      return valueOfPrefix;
+    }
     valueOfPrefix = radix * valueOfPrefix + newChar;
     return ascii2int(radix, valueOfPrefix);
   }
@@ -94,13 +214,221 @@ int ascii2int (int radix, int valueOfPrefix) {
 
 }
 
+int ascii2long (int radix, const char* buf, size_t len, long long* value,
+                size_t* end)
+{
+  size_t             i   = 0;
+  int                neg = 0;
+  unsigned long long acc = 0;
+
+  *value = 0;
+  if (radix > 36 || radix < 2)
+  {
+    *end = 0;
+    return CONV_BAD_RADIX;
+  }
+
+  if (len > 0 && (buf[0] == '-' || buf[0] == '+'))
+  {
+    neg = (buf[0] == '-');
+    i++;
+  }
+
+  /* the largest magnitude, and the largest acc that can take another digit
+     (the strtol() method: no division per digit) */
+  unsigned long long limit  = neg ? (unsigned long long) LLONG_MAX + 1
+                                  : (unsigned long long) LLONG_MAX;
+  unsigned long long cutoff = limit / radix;
+  unsigned           cutlim = limit % radix;
+  size_t             start  = i;
+
+  for (; i < len; i++)
+  {
+    unsigned d = digit_values[(unsigned char) buf[i]];
+    if (d >= (unsigned) radix)
+    {
+      break;
+    }
+    if (acc > cutoff || (acc == cutoff && d > cutlim))
+    {
+      *end = i;
+      return CONV_OVERFLOW;
+    }
+    acc = acc * radix + d;
+  }
+
+  *end = i;
+  if (i == start)
+  {
+    return CONV_NO_DIGITS;
+  }
+  *value = neg ? (long long) (0ull - acc) : (long long) acc;
+  return CONV_OK;
+}
+
+/** true for the characters that separate numbers in a stream */
+static int is_space (char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',';
+}
+
+/** size of the chunks a numstream reads */
+#define NUMSTREAM_CHUNK (64 * 1024)
+
+/** a FILE read a chunk at a time */
+struct numstream
+{
+  FILE*     f;
+  size_t    pos;      /* next character in buf              */
+  size_t    len;      /* characters in buf                  */
+  long long base;     /* file offset of buf[0]              */
+  long long offset;   /* offset of the last number or error */
+  int       eof;      /* f has no more data                 */
+  char      buf[NUMSTREAM_CHUNK];
+};
+
+numstream_t* numstream_open (FILE* f)
+{
+  numstream_t* ns = malloc(sizeof(numstream_t));
+
+  if (ns != NULL)
+  {
+    ns->f      = f;
+    ns->pos    = 0;
+    ns->len    = 0;
+    ns->base   = 0;
+    ns->offset = 0;
+    ns->eof    = 0;
+  }
+  return ns;
+}
+
+void numstream_close (numstream_t* ns)
+{
+  free(ns);
+}
+
+long long numstream_offset (numstream_t* ns)
+{
+  return ns->offset;
+}
+
+/** Move the unread characters to the front of the buffer and read more.
+ *  @return 0 if nothing more could be read: at the end of the file, after
+ *  a read error, or when the unread characters fill the buffer
+ */
+static int numstream_fill (numstream_t* ns)
+{
+  if (ns->eof)
+  {
+    return 0;
+  }
+
+  memmove(ns->buf, ns->buf + ns->pos, ns->len - ns->pos);
+  ns->base += ns->pos;
+  ns->len  -= ns->pos;
+  ns->pos   = 0;
+  if (ns->len == sizeof(ns->buf))
+  {
+    return 0;
+  }
+
+  size_t got = fread(ns->buf + ns->len, 1, sizeof(ns->buf) - ns->len, ns->f);
+  ns->len += got;
+  if (feof(ns->f) || ferror(ns->f))
+  {
+    ns->eof = 1;
+  }
+  return got != 0;
+}
+
+/** Skip the rest of a number that does not fit in the buffer */
+static void numstream_skip (numstream_t* ns)
+{
+  for (;;)
+  {
+    while (ns->pos < ns->len && ! is_space(ns->buf[ns->pos]))
+    {
+      ns->pos++;
+    }
+    if (ns->pos < ns->len || ! numstream_fill(ns))
+    {
+      break;
+    }
+  }
+}
+
+int numstream_next (numstream_t* ns, int radix, long long* value)
+{
+  size_t end;
+
+  /* skip separators */
+  for (;;)
+  {
+    while (ns->pos < ns->len && is_space(ns->buf[ns->pos]))
+    {
+      ns->pos++;
+    }
+    if (ns->pos < ns->len || ! numstream_fill(ns))
+    {
+      break;
+    }
+  }
+
+  ns->offset = ns->base + ns->pos;
+  if (ns->pos == ns->len)
+  {
+    return CONV_EOF;
+  }
+
+  /* make sure the whole number is in the buffer */
+  for (end = ns->pos; ; end++)
+  {
+    if (end == ns->len)
+    {
+      size_t done = end - ns->pos;
+      int    more = numstream_fill(ns); /* moves the number to buf[0] */
+      end = ns->pos + done;
+      if (end == sizeof(ns->buf)) /* longer than the buffer */
+      {
+        ns->pos = end;
+        numstream_skip(ns);
+        return CONV_TOO_LONG;
+      }
+      if (! more) /* at EOF */
+      {
+        break;
+      }
+    }
+    if (is_space(ns->buf[end]))
+    {
+      break;
+    }
+  }
+
+  size_t used;
+  int    result = ascii2long(radix, ns->buf + ns->pos, end - ns->pos, value,
+                             &used);
+  if (result == CONV_OK && used != end - ns->pos)
+  {
+    result = CONV_BAD_DIGIT;
+  }
+
+  if (result != CONV_OK)
+  {
+    ns->offset = ns->base + ns->pos + used;
+  }
+  ns->pos = end; /* go on with the next number even after an error */
+  return result;
+}
+
+
 /** @todo implement in <code>numconv.c</code> based on documentation contained 
  *  in <code>numconv.h</code>.
  */
 void int2ascii (int radix, int value) {
   int remain;
-  remain = value % radix;
-  value = value / radix;
+  divRem(value, radix, &value, &remain);
   if (value != 0)
    {
      int2ascii(radix, value);
@@ -108,39 +436,352 @@ void int2ascii (int radix, int value) {
    putchar(int2char(radix, remain));
 }
 
+int int2buf (int radix, int value, char* buf)
+{
+  char     tmp[INT2BUF_SIZE];
+  char*    p = tmp + sizeof(tmp);
+  unsigned u = (value < 0) ? 0u - (unsigned) value : (unsigned) value;
+  int      len;
+
+  if (radix > 36 || radix < 2)
+  {
+    buf[0] = '\0';
+    return 0;
+  }
+
+  /* right to left, so the digits never have to be reversed */
+  if (radix == 10)
+  {
+    for (; u >= 100; u /= 100)
+    {
+      p -= 2;
+      memcpy(p, decimal_pairs + 2 * (u % 100), 2);
+    }
+    if (u >= 10)
+    {
+      p -= 2;
+      memcpy(p, decimal_pairs + 2 * u, 2);
+    }
+    else
+    {
+      *--p = digit_chars[u];
+    }
+  }
+  else if (radix == 16)
+  {
+    for (; u >= 256; u >>= 8)
+    {
+      p -= 2;
+      memcpy(p, hex_pairs + 2 * (u & 0xFF), 2);
+    }
+    if (u >= 16)
+    {
+      p -= 2;
+      memcpy(p, hex_pairs + 2 * u, 2);
+    }
+    else
+    {
+      *--p = digit_chars[u];
+    }
+  }
+  else
+  {
+    do
+    {
+      unsigned rem;
+      u = radix_div(u, radix, &rem);
+      *--p = digit_chars[rem];
+    } while (u != 0);
+  }
+
+  if (value < 0)
+  {
+    *--p = '-';
+  }
+
+  len = tmp + sizeof(tmp) - p;
+  memcpy(buf, p, len);
+  buf[len] = '\0';
+  return len;
+}
+
+int ints2buf (int radix, const int* values, int count, char* buf)
+{
+  char* p = buf;
+
+  for (int i = 0; i < count; i++)
+  {
+    p += int2buf(radix, values[i], p);
+    *p++ = '\n';
+  }
+  *p = '\0';
+  return p - buf;
+}
+
+int ints2ascii (FILE* f, int radix, const int* values, int count)
+{
+  char* buf = malloc((size_t) count * INT2BUF_SIZE + 1);
+
+  if (buf == NULL)
+  {
+    return -1;
+  }
+
+  size_t len    = ints2buf(radix, values, count, buf);
+  int    result = (fwrite(buf, 1, len, f) == len) ? 0 : -1;
+
+  free(buf);
+  return result;
+}
+
 /** @todo implement in <code>numconv.c</code> based on documentation contained 
  *  in <code>numconv.h</code>.
  */
 double frac2double (int radix) 
 {
-if (origR == 0)
+  size_t len = 0;
+  size_t cap = 64;
+  char*  buf = malloc(cap);
+  int    c;
+
+  /* collect the digits, then convert them all at once */
+  while (buf != NULL && (c = getchar()) != '\n' && c != EOF)
+  {
+    if (len == cap)
+    {
+      char* bigger = realloc(buf, cap *= 2);
+      if (bigger == NULL)
+      {
+        break;
+      }
+      buf = bigger;
+    }
+    buf[len++] = c;
+  }
+
+  double result = (buf != NULL) ? digits2frac(radix, buf, len) : 0.0;
+  free(buf);
+  return result;
+}
+
+/** an unsigned integer of any size, 32 bits per limb, least significant
+ *  limb first
+ */
+typedef struct bignum
 {
- origR = radix;
+  int       len;   /* limbs in use (no leading zero limbs) */
+  uint32_t* limb;
+} bignum_t;
+
+/** b = b * m + a */
+static void big_mul_add (bignum_t* b, uint32_t m, uint32_t a)
+{
+  uint64_t carry = a;
+
+  for (int i = 0; i < b->len; i++)
+  {
+    carry      += (uint64_t) b->limb[i] * m;
+    b->limb[i]  = (uint32_t) carry;
+    carry     >>= 32;
+  }
+  if (carry)
+  {
+    b->limb[b->len++] = (uint32_t) carry;
+  }
 }
-  char c = getchar();
-  double result;
-  double val = c + 0;
 
-  if ((val < 58) && (val > 47))
+/** Return the number of significant bits of b */
+static int big_bits (const bignum_t* b)
+{
+  if (b->len == 0)
   {
-   val = val - 48;
+    return 0;
   }
+  return 32 * (b->len - 1) + 32 - __builtin_clz(b->limb[b->len - 1]);
+}
+
+/** b = b &lt;&lt; bits */
+static void big_shl (bignum_t* b, int bits)
+{
+  int words = bits / 32;
+  int shift = bits % 32;
 
-  if ((val > 64) && (val < 91))
+  if (b->len == 0)
   {
-   val = val - 55;
+    return;
   }
+  b->limb[b->len + words] = 0;
+  for (int i = b->len - 1; i >= 0; i--)
+  {
+    uint64_t v = (uint64_t) b->limb[i] << shift;
+    b->limb[i + words + 1] |= (uint32_t) (v >> 32);
+    b->limb[i + words]      = (uint32_t) v;
+  }
+  memset(b->limb, 0, words * sizeof(uint32_t));
+  b->len += words + 1;
+  while (b->len > 0 && b->limb[b->len - 1] == 0)
+  {
+    b->len--;
+  }
+}
 
-  if ((val > 96) && (val < 123))
+/** b = b &gt;&gt; 1 */
+static void big_shr1 (bignum_t* b)
+{
+  for (int i = 0; i < b->len; i++)
   {
-   val = val - 87;
+    b->limb[i] >>= 1;
+    if (i + 1 < b->len)
+    {
+      b->limb[i] |= b->limb[i + 1] << 31;
+    }
   }
+  if (b->len > 0 && b->limb[b->len - 1] == 0)
+  {
+    b->len--;
+  }
+}
 
-  if (c != '\n')
+/** Compare a and b (-1, 0 or 1) */
+static int big_cmp (const bignum_t* a, const bignum_t* b)
+{
+  if (a->len != b->len)
+  {
+    return (a->len > b->len) ? 1 : -1;
+  }
+  for (int i = a->len - 1; i >= 0; i--)
+  {
+    if (a->limb[i] != b->limb[i])
+    {
+      return (a->limb[i] > b->limb[i]) ? 1 : -1;
+    }
+  }
+  return 0;
+}
+
+/** a = a - b, where a &gt;= b */
+static void big_sub (bignum_t* a, const bignum_t* b)
+{
+  int64_t borrow = 0;
+
+  for (int i = 0; i < a->len; i++)
+  {
+    int64_t d = (int64_t) a->limb[i] - (i < b->len ? b->limb[i] : 0) - borrow;
+    borrow     = (d < 0);
+    a->limb[i] = (uint32_t) (d + (borrow << 32));
+  }
+  while (a->len > 0 && a->limb[a->len - 1] == 0)
+  {
+    a->len--;
+  }
+}
+
+/** Convert n significant digits (the last one not 0) exactly: the value is
+ *  num / radix^n, both kept as big integers. The quotient is found to 54
+ *  or 55 bits and rounded to nearest even, with the remainder deciding
+ *  ties.
+ */
+static double big_frac (int radix, const char* digits, size_t n)
+{
+  int       limbs = (int) (n * 6 / 32) + 6; /* log2(36) < 6, and 55 bits more */
+  uint32_t* mem   = calloc(3 * (size_t) limbs, sizeof(uint32_t));
+  bignum_t  num   = { 0, mem };
+  bignum_t  den   = { 1, mem + limbs };
+  bignum_t  rem;
+
+  if (mem == NULL)
+  {
+    return NAN;
+  }
+  den.limb[0] = 1;
+  for (size_t i = 0; i < n; i++)
+  {
+    big_mul_add(&num, radix, digit_values[(unsigned char) digits[i]]);
+    big_mul_add(&den, radix, 0);
+  }
+
+  /* num * 2^k / den is in [2^53, 2^55), except that k stops at 1075, below
+     which the result is a subnormal (fewer bits) */
+  int k = 54 + big_bits(&den) - big_bits(&num);
+  if (k > 1075)
+  {
+    k = 1075;
+  }
+  big_shl(&num, k);
+  big_shl(&den, 55);
+  rem = num;
+
+  uint64_t q = 0;
+  for (int b = 55; b >= 0; b--)
+  {
+    if (big_cmp(&rem, &den) >= 0)
+    {
+      big_sub(&rem, &den);
+      q |= 1ull << b;
+    }
+    big_shr1(&den);
+  }
+
+  int sticky = (rem.len != 0);
+  if (q >= (1ull << 54))
+  {
+    sticky |= q & 1;
+    q >>= 1;
+    k--;
+  }
+  free(mem);
+
+  /* q holds the result and one more bit: round to nearest even */
+  uint64_t mant = q >> 1;
+  if ((q & 1) && (sticky || (mant & 1)))
+  {
+    mant++;
+  }
+  return ldexp((double) mant, -(k - 1));
+}
+
+double digits2frac (int radix, const char* digits, size_t len)
+{
+  size_t   n   = 0;
+  size_t   i;
+  uint64_t num = 0;
+  uint64_t den = 1;
+
+  if (radix > 36 || radix < 2)
+  {
+    return 0.0;
+  }
+  while (n < len && digit_values[(unsigned char) digits[n]] < radix)
+  {
+    n++;
+  }
+  while (n > 0 && digits[n - 1] == '0') /* trailing zeros add nothing */
+  {
+    n--;
+  }
+
+  /* when num and radix^n are exact doubles, one division rounds correctly */
+  for (i = 0; i < n && den <= (1ull << 53) / radix; i++)
+  {
+    num = num * radix + digit_values[(unsigned char) digits[i]];
+    den *= radix;
+  }
+  if (i == n)
+  {
+    return (double) num / (double) den;
+  }
+  return big_frac(radix, digits, n);
+}
+
+void fracs2double (int radix, const char* const* digits, int count,
+                   double* results)
+{
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+  for (int i = 0; i < count; i++)
   {
-    result = frac2double(origR * radix) + (val / radix);
+    results[i] = digits2frac(radix, digits[i], strlen(digits[i]));
   }
-  
-  return result; 
 }
 
@@ -24,11 +24,18 @@
  * UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
  */
 
+#include <stddef.h>
+#include <stdio.h>
+
 /** @file numconv.h
- *  @brief Defines interface of numconv.c functions (do not modify)
+ *  @brief Defines interface of numconv.c functions
  *  @details This file defines the interface to a C file numconv.c that
  *  you will complete. You will learn how to use the C language operators
  *  for address-of (<b>&amp;</b>), and dereferencing pointers <b>*</b>).
+ *  <p>
+ *  The functions after <code>frac2double()</code> are not part of the
+ *  assignment: they convert many numbers at once, from memory or from a
+ *  file, for programs that need speed rather than recursion.
  */
 
 /** Return the character corresponding to a value.
@@ -130,8 +137,9 @@ void int2ascii (int radix, int value);
  *  standard input. You must read one character at a time by using the
  *  built-in <code>getchar()</code> function which simply returns the next
  *  character available in the standard input. The end of the string is signaled
- *  by a newline character ('\\n'). You <b>MUST</b> implement this function
- *  recursively. That means you shouldn't have loops. For information on the
+ *  by a newline character ('\\n'). The digits are collected and converted
+ *  by <code>digits2frac()</code>, so the result is correctly rounded and the
+ *  function keeps no state between calls. For information on the
  *  algorithm, see Section 4 (page 8) on Sanjay's handout titled "Number
  *  Systems" (referenced in the main page). You may assume that the string is
  *  legal in the given radix (letters may be uppercase or lowercase). The string
@@ -155,4 +163,154 @@ void int2ascii (int radix, int value);
  */
 double frac2double (int radix);
 
+/** Convert the digits after the radix point of a fraction to the nearest
+ *  double (ties to even), however many digits there are. The digits are
+ *  converted exactly, as an integer over a power of the radix; when both
+ *  fit in 53 bits a single division gives the answer, otherwise big
+ *  integers are used. The function is reentrant.
+ *  @param radix - the base you are working in (2-36)
+ *  @param digits - the digits after the radix point (need not be
+ *  terminated); conversion stops at the first illegal digit
+ *  @param len - the number of characters available
+ *  @return the value of the fraction, 0 if the radix is not legal
+ */
+double digits2frac (int radix, const char* digits, size_t len);
+
+/** Convert many fractions with <code>digits2frac()</code>. When compiled
+ *  with OpenMP (<code>-fopenmp</code>) the strings are shared among threads.
+ *  @param radix - the base you are working in (2-36)
+ *  @param digits - the 0 terminated digits of each fraction
+ *  @param count - the number of fractions
+ *  @param results - where the values are stored
+ */
+void fracs2double (int radix, const char* const* digits, int count,
+                   double* results);
+
+/** Size of a buffer that holds any int in any radix: a sign, 32 binary
+ *  digits and the terminating 0
+ */
+#define INT2BUF_SIZE 34
+
+/** Convert a number to a string in the specified radix. Unlike
+ *  <code>int2ascii()</code>, this does not recurse or print: the digits are
+ *  produced right to left (two at a time for radix 10 and 16) and copied to
+ *  the caller's buffer. Negative numbers, including INT_MIN, get a leading
+ *  '-'.
+ *  @param radix - the base you are working in (2-36)
+ *  @param value - the number to convert
+ *  @param buf - where the string is stored (at least INT2BUF_SIZE bytes)
+ *  @return the length of the string, 0 (and an empty string) if the radix is
+ *  not legal
+ */
+int int2buf (int radix, int value, char* buf);
+
+/** Convert an array of numbers to one string, each number followed by a
+ *  newline.
+ *  @param radix - the base you are working in (2-36)
+ *  @param values - the numbers to convert
+ *  @param count - the number of values
+ *  @param buf - where the string is stored (at least
+ *  <code>count * INT2BUF_SIZE + 1</code> bytes)
+ *  @return the length of the string
+ */
+int ints2buf (int radix, const int* values, int count, char* buf);
+
+/** Write an array of numbers to a file, one per line, with a single
+ *  <code>fwrite()</code> of a buffer filled by <code>ints2buf()</code>.
+ *  @param f - the file
+ *  @param radix - the base you are working in (2-36)
+ *  @param values - the numbers to convert
+ *  @param count - the number of values
+ *  @return 0 on success, -1 if the buffer could not be allocated or written
+ */
+int ints2ascii (FILE* f, int radix, const int* values, int count);
+
+/** ascii2long()/numstream_next() results: a number was converted */
+#define CONV_OK        0
+
+/** numstream_next() result: there are no more numbers */
+#define CONV_EOF       1
+
+/** ascii2long()/numstream_next() result: there was no digit */
+#define CONV_NO_DIGITS 2
+
+/** ascii2long()/numstream_next() result: the number does not fit a
+ *  long long
+ */
+#define CONV_OVERFLOW  3
+
+/** numstream_next() result: the number is followed by a character that is
+ *  not a digit or a separator
+ */
+#define CONV_BAD_DIGIT 4
+
+/** ascii2long()/numstream_next() result: the radix is not 2-36 */
+#define CONV_BAD_RADIX 5
+
+/** numstream_next() result: the number is longer than the stream's buffer
+ *  (64K characters)
+ */
+#define CONV_TOO_LONG  6
+
+/** Convert a number in memory to a 64 bit value, without recursion or
+ *  <code>getchar()</code>. The number is an optional '+' or '-' followed by
+ *  digits (letters may be uppercase or lowercase); it ends at the first
+ *  character that is not a digit in the radix, or after len characters.
+ *  Overflow is detected without a division per digit.
+ *  @param radix - the base you are working in (2-36)
+ *  @param buf - the characters (need not be terminated)
+ *  @param len - the number of characters available
+ *  @param value - where the value is stored (0 on error)
+ *  @param end - where the offset of the first character not converted is
+ *  stored. On overflow this is the digit that did not fit.
+ *  @return CONV_OK, CONV_NO_DIGITS, CONV_OVERFLOW or CONV_BAD_RADIX
+ */
+int ascii2long (int radix, const char* buf, size_t len, long long* value,
+                size_t* end);
+
+/** A file of numbers separated by spaces, tabs, commas or newlines, read in
+ *  large chunks (opaque)
+ */
+typedef struct numstream numstream_t;
+
+/** Start reading numbers from a file
+ *  @param f - the file, positioned at the first number
+ *  @return the stream, or NULL if it could not be allocated
+ */
+numstream_t* numstream_open (FILE* f);
+
+/** Release a stream (the file is not closed) */
+void numstream_close (numstream_t* ns);
+
+/** Convert the next number in a stream with <code>ascii2long()</code>.
+ *  After an error the rest of the bad number is skipped, so the next call
+ *  goes on with the following number.
+ *  @param ns - the stream
+ *  @param radix - the base you are working in (2-36)
+ *  @param value - where the value is stored
+ *  @return CONV_OK, an error from <code>ascii2long()</code>, CONV_BAD_DIGIT
+ *  or CONV_TOO_LONG, or CONV_EOF at the end of the file or on a read error
+ *  (use <code>ferror()</code> to tell them apart)
+ */
+int numstream_next (numstream_t* ns, int radix, long long* value);
+
+/** Return the offset in the file of the number last returned by
+ *  <code>numstream_next()</code>, or of the character that caused its error
+ */
+long long numstream_offset (numstream_t* ns);
+
+/** Convert a buffer of digit characters to their values, stopping at the
+ *  first character that is not a legal digit in the radix. Letters may be
+ *  uppercase or lowercase. The characters are classified with a 256 entry
+ *  table, or 16 at a time with SSE2 when it is available.
+ *  @param radix - the base you are working in (2-36)
+ *  @param digits - the characters (need not be terminated)
+ *  @param len - the number of characters
+ *  @param values - where the value of each digit is stored (len bytes)
+ *  @return the number of leading characters that are legal digits; this many
+ *  values are stored. 0 if the radix is not legal.
+ */
+int digits2values (int radix, const char* digits, int len,
+                   unsigned char* values);
+
 #endif
@@ -20,9 +20,11 @@
  * UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
  */
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "numconv.h"
 
 /** @mainpage Number Conversion in C
@@ -52,6 +54,16 @@
  *   <code>int2ascii()</code>)</li>
  * <li><b>f2d</b> convert a string representing a fraction into a double (tests
  *   <code>frac2double()</code>)</li>
+ * <li><b>bench</b> time each conversion on generated numbers and check the
+ *   results against <code>strtol()</code>/<code>strtod()</code></li>
+ * <li><b>dvb</b> time <code>divRem()</code> against the <code>/</code> and
+ *   <code>%</code> operators for each radix</li>
+ * <li><b>a2l</b> convert the numbers in the standard input to 64 bit values
+ *   (tests <code>numstream_next()</code> and <code>ascii2long()</code>)</li>
+ * <li><b>i2b</b> convert a number to a string in a buffer (tests
+ *   <code>int2buf()</code>)</li>
+ * <li><b>d2v</b> convert a string of digits to their values (tests
+ *   <code>digits2values()</code>)</li>
  * </ul>
  * <p>
  * The 2nd parameter is always the radix you work in (2..36). The 3rd
@@ -74,10 +86,332 @@ static void usage() {
   puts("       testConv a2i radix (the string is entered through the standard input)");
   puts("       testConv i2a radix number");
   puts("       testConv f2d radix (the string is entered through the standard input)");
+  puts("       testConv bench radix [count] (radix 0 runs 2, 8, 10, 16 and 36)");
+  puts("       testConv dvb count (count is the number of divisions per radix)");
+  puts("       testConv a2l radix (the numbers are entered through the standard input)");
+  puts("       testConv i2b radix number");
+  puts("       testConv d2v radix digits");
   puts("The radix and number parameters are always base 10 numbers.");
   exit(1);
 }
 
+/** Parse a count of operations, which must be from 1 to INT_MAX
+ *  @param str - the parameter, a base 10 number
+ *  @return the count (does not return if the parameter is not valid)
+ */
+static int parseCount (const char* str) {
+  char* end;
+  long  count = strtol(str, &end, 10);
+
+  if ((end == str) || (*end != '\0') || (count < 1) || (count > INT_MAX))
+    usage();
+  return (int) count;
+}
+
+/** divRem() as it was, with the C operators, for comparison */
+static void __attribute__((noinline)) plainDivRem (int numerator, int divisor,
+                                                   int* quotient,
+                                                   int* remainder) {
+  *quotient  = numerator / divisor;
+  *remainder = numerator % divisor;
+}
+
+/** Time <code>divRem()</code> and the C operators on the same numerators
+ *  for each radix, and check that they agree for every numerator. Each
+ *  timed division depends on the one before it, as the digits of a
+ *  conversion do, so the times are latencies.
+ *  @param count - the number of divisions timed per radix
+ *  @return 0, or 1 if the numerators could not be allocated
+ */
+static int divBench (int count) {
+  int*     nums  = malloc(count * sizeof(int));
+  unsigned seed  = 12345;
+  long     wrong = 0;
+
+  if (nums == NULL) {
+    printf("dvb: cannot allocate %d numerators\n", count);
+    return 1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    seed    = seed * 1103515245 + 12345;
+    nums[i] = (seed >> 1) >> (seed % 24); /* short and long numbers */
+  }
+
+  printf("radix   divRem ns/op   / and %% ns/op\n");
+  for (int radix = 2; radix <= 36; radix++) {
+    int     q1 = 0, r1 = 0, q2 = 0, r2 = 0;
+    clock_t start = clock();
+
+    for (int i = 0; i < count; i++)
+      divRem(nums[i] ^ (q1 & 1), radix, &q1, &r1);
+    double t1 = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (int i = 0; i < count; i++)
+      plainDivRem(nums[i] ^ (q2 & 1), radix, &q2, &r2);
+    double t2 = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    printf("%5d %14.2f %16.2f\n", radix, 1e9 * t1 / count, 1e9 * t2 / count);
+
+    for (int i = 0; i < count; i++) {
+      divRem(nums[i], radix, &q1, &r1);
+      wrong += (q1 != nums[i] / radix) || (r1 != nums[i] % radix);
+    }
+  }
+  printf("results %s", wrong ? "DIFFER" : "agree");
+  free(nums);
+  return 0;
+}
+
+/** timed runs of each benchmark, after one untimed warm up run */
+#define BENCH_REPS 5
+
+/** default number of conversions per run */
+#define BENCH_COUNT 1000000
+
+/** generated input for the benchmarks of one radix */
+typedef struct bench_data {
+  int     radix;
+  int     count;
+  int*    values;    /**< random ints, positive and negative      */
+  char**  numbers;   /**< values written in the radix             */
+  char**  fracs;     /**< 1 to 30 random digits of a fraction     */
+  char*   chars;     /**< count random characters                 */
+  char*   text;      /**< buffer for int2buf()/ints2buf() output  */
+  double* results;   /**< digits2frac() results                   */
+} bench_data_t;
+
+/** xorshift, so each run uses the same input */
+static unsigned benchRandom (void) {
+  static unsigned seed = 2463534242u;
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+/** Write a value in a radix the simple way, independent of numconv.c
+ *  @return the string, or NULL if it could not be allocated
+ */
+static char* refFormat (int radix, int value) {
+  char      tmp[40];
+  char*     p = tmp + sizeof(tmp);
+  long long v = value;
+  long long u = (v < 0) ? -v : v;
+
+  *--p = '\0';
+  do {
+    *--p = "0123456789abcdefghijklmnopqrstuvwxyz"[u % radix];
+    u   /= radix;
+  } while (u);
+  if (v < 0)
+    *--p = '-';
+  char* str = malloc(strlen(p) + 1);
+  return str ? strcpy(str, p) : NULL;
+}
+
+/** Release the input of the benchmarks (any part may be missing) */
+static void benchFree (bench_data_t* d) {
+  for (int i = 0; i < d->count; i++) {
+    if (d->numbers)
+      free(d->numbers[i]);
+    if (d->fracs)
+      free(d->fracs[i]);
+  }
+  free(d->values);
+  free(d->numbers);
+  free(d->fracs);
+  free(d->chars);
+  free(d->text);
+  free(d->results);
+}
+
+/** Allocate and fill the input of the benchmarks
+ *  @return 0, or 1 if memory could not be allocated (nothing is kept)
+ */
+static int benchSetup (bench_data_t* d, int radix, int count) {
+  d->radix   = radix;
+  d->count   = count;
+  d->values  = malloc(count * sizeof(int));
+  d->numbers = calloc(count, sizeof(char*));
+  d->fracs   = calloc(count, sizeof(char*));
+  d->chars   = malloc(count);
+  d->text    = malloc((size_t) count * INT2BUF_SIZE + 1);
+  d->results = malloc(count * sizeof(double));
+
+  if (! (d->values && d->numbers && d->fracs && d->chars && d->text
+         && d->results)) {
+    benchFree(d);
+    return 1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    int len = 1 + benchRandom() % 30;
+    d->values[i]  = (int) benchRandom() >> (benchRandom() % 31);
+    d->numbers[i] = refFormat(radix, d->values[i]);
+    d->fracs[i]   = malloc(len + 1);
+    if (! (d->numbers[i] && d->fracs[i])) {
+      benchFree(d);
+      return 1;
+    }
+    for (int j = 0; j < len; j++)
+      d->fracs[i][j] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"[benchRandom() % radix];
+    d->fracs[i][len] = '\0';
+    d->chars[i]      = "0123456789abcdefghijklmnopqrstuvwxyz"
+                       "ABCDEFGHIJKLMNOPQRSTUVWXYZ+-. "[benchRandom() % 66];
+  }
+  return 0;
+}
+
+
+/* one run of each benchmark; the result keeps the work from being removed */
+
+static long runChar2int (bench_data_t* d) {
+  long sum = 0;
+  for (int i = 0; i < d->count; i++)
+    sum += char2int(d->radix, d->chars[i]);
+  return sum;
+}
+
+static long runInt2char (bench_data_t* d) {
+  long sum = 0;
+  for (int i = 0; i < d->count; i++)
+    sum += int2char(d->radix, (unsigned) d->values[i] % d->radix);
+  return sum;
+}
+
+static long runDivRem (bench_data_t* d) {
+  long sum = 0;
+  for (int i = 0; i < d->count; i++) {
+    int q, r;
+    divRem(d->values[i] & 0x7FFFFFFF, d->radix, &q, &r);
+    sum += q + r;
+  }
+  return sum;
+}
+
+static long runInt2buf (bench_data_t* d) {
+  long sum = 0;
+  char buf[INT2BUF_SIZE];
+  for (int i = 0; i < d->count; i++)
+    sum += int2buf(d->radix, d->values[i], buf);
+  return sum;
+}
+
+static long runInts2buf (bench_data_t* d) {
+  return ints2buf(d->radix, d->values, d->count, d->text);
+}
+
+static long runAscii2long (bench_data_t* d) {
+  long sum = 0;
+  for (int i = 0; i < d->count; i++) {
+    long long value;
+    size_t    end;
+    ascii2long(d->radix, d->numbers[i], strlen(d->numbers[i]), &value, &end);
+    sum += value;
+  }
+  return sum;
+}
+
+static long runDigits2values (bench_data_t* d) {
+  unsigned char values[40];
+  long          sum = 0;
+  for (int i = 0; i < d->count; i++)
+    sum += digits2values(d->radix, d->fracs[i], strlen(d->fracs[i]), values);
+  return sum;
+}
+
+static long runDigits2frac (bench_data_t* d) {
+  fracs2double(d->radix, (const char* const*) d->fracs, d->count, d->results);
+  return (long) d->results[0];
+}
+
+/** Check the conversions against the C library
+ *  @return the number of wrong results
+ */
+static int benchCheck (bench_data_t* d) {
+  int  wrong = 0;
+  char buf[INT2BUF_SIZE];
+  char str[2] = { 0, 0 };
+
+  for (int i = 0; i < d->count; i++) {
+    long long value;
+    size_t    end;
+    int       q, r;
+    int       n = d->values[i];
+
+    int2buf(d->radix, n, buf);
+    wrong += (strtol(buf, NULL, d->radix) != n);
+    ascii2long(d->radix, d->numbers[i], strlen(d->numbers[i]), &value, &end);
+    wrong += (value != strtoll(d->numbers[i], NULL, d->radix));
+    divRem(n & 0x7FFFFFFF, d->radix, &q, &r);
+    wrong += (q != (n & 0x7FFFFFFF) / d->radix) || (r != (n & 0x7FFFFFFF) % d->radix);
+
+    str[0] = d->chars[i];
+    char* endp;
+    long  digit = strtol(str, &endp, d->radix);
+    wrong += (char2int(d->radix, d->chars[i]) != ((*endp == '\0') ? digit : -1));
+
+    /* strtod() reads fractions in radix 10 and 16 */
+    if (d->radix == 10 || d->radix == 16) {
+      char frac[40];
+      sprintf(frac, "%s%s", (d->radix == 10) ? "0." : "0x0.", d->fracs[i]);
+      wrong += (digits2frac(d->radix, d->fracs[i], strlen(d->fracs[i]))
+                != strtod(frac, NULL));
+    }
+  }
+  return wrong;
+}
+
+/** Time one benchmark: a warm up run, then the best of BENCH_REPS runs */
+static void benchTime (const char* name, long (*run) (bench_data_t*),
+                       bench_data_t* d) {
+  double best = 1e30;
+
+  run(d);
+  for (int rep = 0; rep < BENCH_REPS; rep++) {
+    clock_t start = clock();
+    run(d);
+    double  secs  = (double) (clock() - start) / CLOCKS_PER_SEC;
+    if (secs < best)
+      best = secs;
+  }
+  if (best <= 0)
+    best = 1.0 / CLOCKS_PER_SEC;
+  printf("  %-16s %10.2f ns/op %12.0f conversions/sec\n", name,
+         1e9 * best / d->count, d->count / best);
+}
+
+/** Time and check each conversion in one radix
+ *  @return 0, or 1 if the input could not be allocated
+ */
+static int bench (int radix, int count) {
+  bench_data_t d;
+
+  if (benchSetup(&d, radix, count) != 0) {
+    printf("bench: cannot allocate %d conversions\n", count);
+    return 1;
+  }
+  printf("radix %d, %d conversions per run, best of %d runs\n", radix, count,
+         BENCH_REPS);
+  benchTime("char2int", runChar2int, &d);
+  benchTime("int2char", runInt2char, &d);
+  benchTime("divRem", runDivRem, &d);
+  benchTime("int2buf", runInt2buf, &d);
+  benchTime("ints2buf", runInts2buf, &d);
+  benchTime("ascii2long", runAscii2long, &d);
+  benchTime("digits2values", runDigits2values, &d);
+  benchTime("digits2frac", runDigits2frac, &d);
+
+  int wrong = benchCheck(&d);
+  printf("  check against strtol()%s: %s\n",
+         (radix == 10 || radix == 16) ? "/strtod()" : "",
+         wrong ? "FAILED" : "OK");
+  benchFree(&d);
+  return 0;
+}
+
 /** Entry point of the program
  * @param argc count of arguments, will always be at least 1
  * @param argv array of parameters to program argv[0] is the name of
@@ -147,6 +481,77 @@ int main (int argc, char* argv[]) {
     printf("frac2double(%d) returns %f", radix, frac2double(radix));
   }
   
+  else if (strcmp(op, "bench") == 0) {
+    if (argc > 4 || radix == 1 || radix < 0 || radix > 36)
+      usage();
+
+    int count = (argc == 4) ? parseCount(argv[3]) : BENCH_COUNT;
+
+    if (radix != 0) {
+      if (bench(radix, count) != 0)
+        return 1;
+    }
+    else {
+      int radixes[] = { 2, 8, 10, 16, 36 };
+      for (int i = 0; i < 5; i++) {
+        if (bench(radixes[i], count) != 0)
+          return 1;
+      }
+    }
+    printf("bench done");
+  }
+
+  else if (strcmp(op, "dvb") == 0) {
+    if (argc != 3)
+      usage();
+
+    if (divBench(parseCount(argv[2])) != 0)
+      return 1;
+  }
+
+  else if (strcmp(op, "a2l") == 0) {
+    if (argc != 3)
+      usage();
+
+    numstream_t* ns = numstream_open(stdin);
+    long long    value;
+    int          result;
+
+    while ((result = numstream_next(ns, radix, &value)) != CONV_EOF) {
+      if (result == CONV_OK)
+        printf("%lld\n", value);
+      else
+        printf("error %d at offset %lld\n", result, numstream_offset(ns));
+      if (result == CONV_BAD_RADIX)
+        break;
+    }
+    numstream_close(ns);
+    printf("ascii2long(%d) done", radix);
+  }
+
+  else if (strcmp(op, "i2b") == 0) {
+    if (argc != 4)
+      usage();
+
+    char buf[INT2BUF_SIZE];
+    int  n   = atoi(argv[3]);
+    int  len = int2buf(radix, n, buf);
+    printf("int2buf(%d, %d) returns %d \"%s\"", radix, n, len, buf);
+  }
+
+  else if (strcmp(op, "d2v") == 0) {
+    if (argc != 4)
+      usage();
+
+    int           len    = strlen(argv[3]);
+    unsigned char values[len + 1];
+    int           n      = digits2values(radix, argv[3], len, values);
+
+    printf("digits2values(%d, \"%s\") returns %d:", radix, argv[3], n);
+    for (int i = 0; i < n; i++)
+      printf(" %d", values[i]);
+  }
+
   else
     usage();
   
@@ -0,0 +1,502 @@
+#define _POSIX_C_SOURCE 200809L /* for sysconf() */
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "flt16.h"
+
+/** @file testFlt16.c
+ *  @brief Driver to test and time the functions of flt16.h
+ *  @details To see how to use the program, execute <code>./testFlt16</code>
+ *  in a terminal window. Build it with
+ *  <code>gcc -std=c11 -Wall -O2 -pthread flt16.c testFlt16.c -o testFlt16</code>.
+ *  The options are:
+ *  <ul>
+ *  <li><b>h2f</b> convert a half precision value, given in hex, to a float
+ *    and a double</li>
+ *  <li><b>f2h</b> convert a number to half precision, from a float and from
+ *    a double</li>
+ *  <li><b>check</b> compare every path of the bulk functions with the single
+ *    value functions, for all 65536 half precision values and all 2<sup>32
+ *    </sup> floats. When the compiler has a <code>_Float16</code> type its
+ *    conversions are checked too.</li>
+ *  <li><b>add</b>, <b>sub</b> and <b>mul</b> do arithmetic on two half
+ *    precision values, given in hex</li>
+ *  <li><b>verify</b> compare <code>flt16_add()</code>,
+ *    <code>flt16_sub()</code> and <code>flt16_mul()</code> with
+ *    <code>flt16s_arith()</code> and with the same operation done in float,
+ *    for all 2<sup>32</sup> pairs of values, on several threads</li>
+ *  <li><b>bench</b> time each bulk function on each path</li>
+ *  </ul>
+ */
+
+/** number of timed runs of each benchmark (after one warm up run) */
+#define BENCH_REPS 5
+
+/** floats converted at a time by the check */
+#define CHECK_CHUNK (1 << 20)
+
+static const char* path_names[] = { "scalar", "SSE2", "F16C" };
+
+/** Print a usage statement, then exit the program returning a non zero
+ * value, the Linux convention indicating an error
+ */
+static void usage (void) {
+  puts("Usage: testFlt16 h2f hex (for example 3C00)");
+  puts("       testFlt16 f2h number");
+  puts("       testFlt16 check");
+  puts("       testFlt16 add|sub|mul hex hex");
+  puts("       testFlt16 verify [threads]");
+  puts("       testFlt16 bench [count]");
+  exit(1);
+}
+
+static uint32_t floatBits (float f) {
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+static uint64_t doubleBits (double d) {
+  uint64_t u;
+  memcpy(&u, &d, sizeof(u));
+  return u;
+}
+
+/** true if h is a NaN */
+static int isNaN16 (uint16_t h) {
+  return (h & 0x7FFF) > 0x7C00;
+}
+
+/** Check the conversions from half precision: every path, every value */
+static long checkFromHalf (void) {
+  static uint16_t halves[65536];
+  static float    floats[65536];
+  static double   doubles[65536];
+  long            wrong = 0;
+
+  for (int i = 0; i < 65536; i++)
+    halves[i] = i;
+
+  for (flt16_path_t path = FLT16_SCALAR; path <= FLT16_F16C; path++) {
+    long bad = 0;
+    if (flt16_use_path(path) != path)
+      continue;
+    flt16s_to_floats(halves, floats, 65536);
+    flt16s_to_doubles(halves, doubles, 65536);
+    for (int i = 0; i < 65536; i++) {
+      float  f = flt16_to_float(i);
+      double d = flt16_to_double(i);
+      bad += (floatBits(floats[i]) != floatBits(f))
+               || (doubleBits(doubles[i]) != doubleBits(d))
+               || (doubleBits(d) != doubleBits((double) f))
+               || (float_to_flt16(f) != (isNaN16(i) ? (i | 0x200) : i))
+               || (double_to_flt16(d) != (isNaN16(i) ? (i | 0x200) : i));
+#if defined(__FLT16_MAX__)
+      if (!isNaN16(i)) {
+        _Float16 ref;
+        memcpy(&ref, &halves[i], sizeof(ref));
+        bad += (floatBits(f) != floatBits((float) ref));
+      }
+#endif
+    }
+    printf("  half to float/double, %-6s %s\n", path_names[path],
+           bad ? "FAILED" : "OK");
+    wrong += bad;
+  }
+  return wrong;
+}
+
+/** Check the conversions to half precision: every path, every float */
+static long checkToHalf (void) {
+  float*    floats = malloc(CHECK_CHUNK * sizeof(float));
+  double*   doubles = malloc(CHECK_CHUNK * sizeof(double));
+  uint16_t* ref    = malloc(CHECK_CHUNK * sizeof(uint16_t));
+  uint16_t* halves = malloc(CHECK_CHUNK * sizeof(uint16_t));
+  long      wrong  = 0;
+
+  for (uint64_t base = 0; base < (1ull << 32); base += CHECK_CHUNK) {
+    for (int i = 0; i < CHECK_CHUNK; i++) {
+      uint32_t u = base + i;
+      memcpy(&floats[i], &u, sizeof(u));
+      doubles[i] = floats[i];
+      ref[i]     = float_to_flt16(floats[i]);
+#if defined(__FLT16_MAX__)
+      _Float16 h = floats[i];
+      uint16_t hb;
+      memcpy(&hb, &h, sizeof(hb));
+      wrong += isNaN16(ref[i]) ? !isNaN16(hb) : (hb != ref[i]);
+#endif
+    }
+    for (flt16_path_t path = FLT16_SCALAR; path <= FLT16_F16C; path++) {
+      if (flt16_use_path(path) != path)
+        continue;
+      floats_to_flt16s(floats, halves, CHECK_CHUNK);
+      wrong += memcmp(halves, ref, CHECK_CHUNK * sizeof(uint16_t)) != 0;
+    }
+    doubles_to_flt16s(doubles, halves, CHECK_CHUNK);
+    wrong += memcmp(halves, ref, CHECK_CHUNK * sizeof(uint16_t)) != 0;
+  }
+  printf("  float/double to half, all paths %s\n", wrong ? "FAILED" : "OK");
+
+  free(floats);
+  free(doubles);
+  free(ref);
+  free(halves);
+  return wrong;
+}
+
+static const char* op_names[] = { "add", "sub", "mul" };
+
+/** the reference for an operation */
+static uint16_t (*const op_funcs[]) (uint16_t, uint16_t) = {
+  flt16_add, flt16_sub, flt16_mul
+};
+
+/** an operation done in float, then rounded to half. Which NaN comes out
+ *  is up to the compiler and the processor.
+ */
+static uint16_t floatOp (flt16_op_t op, uint16_t a, uint16_t b) {
+  float fa = flt16_to_float(a);
+  float fb = flt16_to_float(b);
+  return float_to_flt16((op == FLT16_ADD) ? fa + fb
+                        : (op == FLT16_SUB) ? fa - fb : fa * fb);
+}
+
+/** one exhaustive check, shared by the threads doing it */
+typedef struct verify_job {
+  flt16_op_t  op;
+  atomic_int  next;    /**< the next value of a to check        */
+  atomic_long wrong;   /**< the number of pairs that disagree   */
+  atomic_uint first;   /**< a pair that disagrees (a << 16 | b) */
+} verify_job_t;
+
+/** Check a against every b, for each a taken from the job */
+static void* verifyThread (void* arg) {
+  verify_job_t* job    = arg;
+  uint16_t*     as     = malloc(65536 * sizeof(uint16_t));
+  uint16_t*     bs     = malloc(65536 * sizeof(uint16_t));
+  uint16_t*     bulk   = malloc(65536 * sizeof(uint16_t));
+  uint16_t      (*ref) (uint16_t, uint16_t) = op_funcs[job->op];
+  int           a;
+
+  for (int b = 0; b < 65536; b++)
+    bs[b] = b;
+
+  while ((a = atomic_fetch_add(&job->next, 1)) < 65536) {
+    long wrong = 0;
+
+    for (int b = 0; b < 65536; b++)
+      as[b] = a;
+    flt16s_arith(job->op, as, bs, bulk, 65536);
+
+    for (int b = 0; b < 65536; b++) {
+      uint16_t r = ref(a, b);
+      uint16_t f = floatOp(job->op, a, b);
+      if ((bulk[b] != r) || ((f != r) && !(isNaN16(f) && isNaN16(r)))) {
+        unsigned none = ~0u;
+        atomic_compare_exchange_strong(&job->first, &none,
+                                       ((unsigned) a << 16) | b);
+        wrong++;
+      }
+    }
+    atomic_fetch_add(&job->wrong, wrong);
+  }
+
+  free(as);
+  free(bs);
+  free(bulk);
+  return NULL;
+}
+
+/** Check every pair of values for one operation on the current path
+ *  @return the number of pairs that disagree
+ */
+static long verifyOp (flt16_op_t op, int threads) {
+  pthread_t*      ids = malloc(threads * sizeof(pthread_t));
+  verify_job_t    job;
+  struct timespec start, end;
+
+  job.op = op;
+  atomic_init(&job.next, 0);
+  atomic_init(&job.wrong, 0);
+  atomic_init(&job.first, ~0u);
+
+  timespec_get(&start, TIME_UTC);
+  for (int t = 0; t < threads; t++)
+    pthread_create(&ids[t], NULL, verifyThread, &job);
+  for (int t = 0; t < threads; t++)
+    pthread_join(ids[t], NULL);
+  timespec_get(&end, TIME_UTC);
+  free(ids);
+
+  long     bad   = atomic_load(&job.wrong);
+  unsigned first = atomic_load(&job.first);
+  printf("  %s: %ld wrong in %.1f s", op_names[op], bad,
+         (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9);
+  if (bad) {
+    uint16_t as[8], bs[8], bulk[8]; /* 8 so a vector path is used */
+    for (int i = 0; i < 8; i++) {
+      as[i] = first >> 16;
+      bs[i] = first & 0xFFFF;
+    }
+    flt16s_arith(op, as, bs, bulk, 8);
+    printf(" (x%04X %s x%04X: reference x%04X, bulk x%04X, float x%04X)",
+           as[0], op_names[op], bs[0], op_funcs[op](as[0], bs[0]), bulk[0],
+           floatOp(op, as[0], bs[0]));
+  }
+  printf("\n");
+  fflush(stdout);
+  return bad;
+}
+
+/** Check every pair of values for each operation, on each vector path */
+static long verify (int threads) {
+  long wrong = 0;
+
+  for (flt16_path_t path = FLT16_SSE2; path <= FLT16_F16C; path++) {
+    if (flt16_use_path(path) != path)
+      continue;
+    printf("checking all 2^32 pairs on %d threads, %s path\n", threads,
+           path_names[path]);
+    fflush(stdout);
+    for (flt16_op_t op = FLT16_ADD; op <= FLT16_MUL; op++)
+      wrong += verifyOp(op, threads);
+  }
+  return wrong;
+}
+
+/** inputs and outputs of the benchmarks */
+typedef struct bench_data {
+  int       count;
+  uint16_t* halves;
+  uint16_t* halves2;
+  float*    floats;
+  double*   doubles;
+  uint16_t* out16;
+  float*    outF;
+  double*   outD;
+} bench_data_t;
+
+static void runToFloats (bench_data_t* d) {
+  flt16s_to_floats(d->halves, d->outF, d->count);
+}
+
+static void runFromFloats (bench_data_t* d) {
+  floats_to_flt16s(d->floats, d->out16, d->count);
+}
+
+static void runToDoubles (bench_data_t* d) {
+  flt16s_to_doubles(d->halves, d->outD, d->count);
+}
+
+static void runFromDoubles (bench_data_t* d) {
+  doubles_to_flt16s(d->doubles, d->out16, d->count);
+}
+
+static void runAdd (bench_data_t* d) {
+  flt16s_arith(FLT16_ADD, d->halves, d->halves2, d->out16, d->count);
+}
+
+static void runMul (bench_data_t* d) {
+  flt16s_arith(FLT16_MUL, d->halves, d->halves2, d->out16, d->count);
+}
+
+/** Time one benchmark: a warm up run, then the best of BENCH_REPS runs */
+static void benchTime (const char* name, void (*run) (bench_data_t*),
+                       bench_data_t* d, double scalar) {
+  double best = 1e30;
+
+  run(d);
+  for (int rep = 0; rep < BENCH_REPS; rep++) {
+    clock_t start = clock();
+    run(d);
+    double  secs  = (double) (clock() - start) / CLOCKS_PER_SEC;
+    if (secs < best)
+      best = secs;
+  }
+  if (best <= 0)
+    best = 1.0 / CLOCKS_PER_SEC;
+  printf("  %-18s %8.3f ns/op %14.0f values/sec", name, 1e9 * best / d->count,
+         d->count / best);
+  if (scalar > 0)
+    printf(" %6.1fx scalar", scalar / best);
+  printf("\n");
+}
+
+/** best time of a run on the scalar path, to compare the others with */
+static double scalarTime (void (*run) (bench_data_t*), bench_data_t* d) {
+  double best = 1e30;
+
+  flt16_use_path(FLT16_SCALAR);
+  for (int rep = 0; rep < BENCH_REPS; rep++) {
+    clock_t start = clock();
+    run(d);
+    double  secs  = (double) (clock() - start) / CLOCKS_PER_SEC;
+    if (secs < best)
+      best = secs;
+  }
+  return (best > 0) ? best : 1.0 / CLOCKS_PER_SEC;
+}
+
+/** Release the arrays of the benchmarks */
+static void benchFree (bench_data_t* d) {
+  free(d->halves);
+  free(d->halves2);
+  free(d->floats);
+  free(d->doubles);
+  free(d->out16);
+  free(d->outF);
+  free(d->outD);
+}
+
+/** Time each bulk function on each path the processor supports
+ *  @return 0, or 1 if the arrays could not be allocated
+ */
+static int bench (int count) {
+  bench_data_t d;
+  unsigned     seed = 12345;
+
+  d.count   = count;
+  d.halves  = malloc(count * sizeof(uint16_t));
+  d.halves2 = malloc(count * sizeof(uint16_t));
+  d.floats  = malloc(count * sizeof(float));
+  d.doubles = malloc(count * sizeof(double));
+  d.out16   = malloc(count * sizeof(uint16_t));
+  d.outF    = malloc(count * sizeof(float));
+  d.outD    = malloc(count * sizeof(double));
+
+  if (! (d.halves && d.halves2 && d.floats && d.doubles && d.out16 && d.outF
+         && d.outD)) {
+    printf("bench: cannot allocate %d values\n", count);
+    benchFree(&d);
+    return 1;
+  }
+
+  /* finite values of every size, some subnormal, some too big */
+  for (int i = 0; i < count; i++) {
+    seed        = seed * 1103515245 + 12345;
+    d.halves[i] = (seed >> 16) & 0xFBFF;
+    d.halves2[i] = ((seed >> 8) & 0x83FF) | 0x3800; /* 0.5 to 2 */
+    d.floats[i] = flt16_to_float(d.halves[i]) * (1.0f + (seed & 0xFF) / 512.0f);
+    d.doubles[i] = d.floats[i];
+  }
+
+  struct {
+    const char* name;
+    void        (*run) (bench_data_t*);
+  } tests[] = {
+    { "flt16s_to_floats",  runToFloats },
+    { "floats_to_flt16s",  runFromFloats },
+    { "flt16s_to_doubles", runToDoubles },
+    { "doubles_to_flt16s", runFromDoubles },
+    { "flt16s_arith add",  runAdd },
+    { "flt16s_arith mul",  runMul },
+  };
+
+  printf("%d values per run, best of %d runs\n", count, BENCH_REPS);
+  for (int t = 0; t < (int) (sizeof(tests) / sizeof(tests[0])); t++) {
+    double scalar = scalarTime(tests[t].run, &d);
+    printf(" %s\n", tests[t].name);
+    for (flt16_path_t path = FLT16_SCALAR; path <= FLT16_F16C; path++) {
+      if (flt16_use_path(path) != path)
+        continue;
+      benchTime(path_names[path], tests[t].run, &d,
+                (path == FLT16_SCALAR) ? 0 : scalar);
+    }
+  }
+
+  benchFree(&d);
+  return 0;
+}
+
+/** Entry point of the program
+ * @param argc count of arguments, will always be at least 1
+ * @param argv array of parameters to program argv[0] is the name of
+ * the program, so additional parameters will begin at index 1.
+ * @return 0 the Linux convention for success.
+ */
+int main (int argc, char* argv[]) {
+  if (argc < 2)
+    usage();
+
+  char* op = argv[1];
+
+  if (strcmp(op, "h2f") == 0) {
+    if (argc != 3)
+      usage();
+
+    uint16_t h = strtol(argv[2], NULL, 16);
+    printf("flt16_to_float(x%04X) returns %.9g, flt16_to_double returns %.17g\n",
+           h, flt16_to_float(h), flt16_to_double(h));
+  }
+
+  else if (strcmp(op, "f2h") == 0) {
+    if (argc != 3)
+      usage();
+
+    double d = strtod(argv[2], NULL);
+    printf("float_to_flt16(%.9g) returns x%04X, double_to_flt16(%.17g) "
+           "returns x%04X\n", (float) d, float_to_flt16(d), d,
+           double_to_flt16(d));
+  }
+
+  else if (strcmp(op, "check") == 0) {
+    if (argc != 2)
+      usage();
+
+    long wrong = checkFromHalf() + checkToHalf();
+    flt16_use_path(FLT16_F16C);
+    return wrong != 0;
+  }
+
+  else if ((strcmp(op, "add") == 0) || (strcmp(op, "sub") == 0)
+           || (strcmp(op, "mul") == 0)) {
+    if (argc != 4)
+      usage();
+
+    int      which = (op[0] == 'a') ? FLT16_ADD : (op[0] == 's') ? FLT16_SUB
+                                                                 : FLT16_MUL;
+    uint16_t a     = strtol(argv[2], NULL, 16);
+    uint16_t b     = strtol(argv[3], NULL, 16);
+    uint16_t r     = op_funcs[which](a, b);
+    printf("flt16_%s(x%04X, x%04X) returns x%04X (%.9g %s %.9g = %.9g)\n", op,
+           a, b, r, flt16_to_float(a), (which == FLT16_ADD) ? "+"
+           : (which == FLT16_SUB) ? "-" : "*", flt16_to_float(b),
+           flt16_to_float(r));
+  }
+
+  else if (strcmp(op, "verify") == 0) {
+    if (argc > 3)
+      usage();
+
+    int threads = (argc == 3) ? atoi(argv[2])
+                              : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    return verify((threads > 0) ? threads : 1) != 0;
+  }
+
+  else if (strcmp(op, "bench") == 0) {
+    if (argc > 3)
+      usage();
+
+    char* end   = "";
+    long  count = (argc == 3) ? strtol(argv[2], &end, 0) : 4000000;
+    if ((*end != '\0') || (count < 1) || (count > INT_MAX))
+      usage();
+
+    printf("best path: %s\n", path_names[flt16_use_path(FLT16_F16C)]);
+    return bench((int) count);
+  }
+
+  else {
+    usage();
+  }
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+#ifndef __BITFIELD_H__
+#define __BITFIELD_H__
+
+/** @file bitfield.h
+ *  @brief fixed position bit fields
+ *  @details The functions of field.h take hi and lo at run time, in either
+ *  order, so every call builds its masks. When the position of a field is
+ *  known when the program is written, the macros below do the same work
+ *  with constants, and each access compiles to a shift and a mask. Here hi
+ *  must be greater than or equal to lo.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/** mask of the bits between hi and lo (inclusive), hi &gt;= lo */
+#define FIELD_MASK(hi, lo) ((uint32_t) ((2ull << (hi)) - (1ull << (lo))))
+
+/** getField(value, hi, lo, false) for constant hi &gt;= lo */
+#define GET_FIELD(value, hi, lo) \
+  ((int) (((uint32_t) (value) & FIELD_MASK(hi, lo)) >> (lo)))
+
+/** getField(value, hi, lo, true) for constant hi &gt;= lo */
+#define GET_SFIELD(value, hi, lo) \
+  ((int) ((int32_t) ((uint32_t) (value) << (31 - (hi))) >> (31 - (hi) + (lo))))
+
+/** setField(oldValue, hi, lo, newValue) for constant hi &gt;= lo */
+#define SET_FIELD(oldValue, hi, lo, newValue)                  \
+  ((int) (((uint32_t) (oldValue) & ~FIELD_MASK(hi, lo))        \
+          | (((uint32_t) (newValue) << (lo)) & FIELD_MASK(hi, lo))))
+
+/** Define <code>get_name(value)</code> and
+ *  <code>set_name(oldValue, newValue)</code> for the field between bits hi
+ *  and lo, for example
+ *  <pre><code>
+ *     FIELD_ACCESSORS(exponent, 14, 10, false)
+ *     int exp = get_exponent(value);
+ *  </code></pre>
+ *  The position is checked when the program is compiled.
+ */
+#define FIELD_ACCESSORS(name, hi, lo, isSigned)                              \
+  _Static_assert((hi) >= (lo) && (hi) < 32 && (lo) >= 0,                     \
+                 "field " #name " must have 31 >= hi >= lo >= 0");           \
+  static inline int get_##name (int value) {                                 \
+    return (isSigned) ? GET_SFIELD(value, hi, lo) : GET_FIELD(value, hi, lo);\
+  }                                                                          \
+  static inline int set_##name (int oldValue, int newValue) {                \
+    return SET_FIELD(oldValue, hi, lo, newValue);                            \
+  }
+
+/** Extract the same unsigned field from each of an array of 16 bit words,
+ *  8 words at a time with SSE2 when it is available.
+ *  @param words the source values
+ *  @param count the number of words
+ *  @param hi the bit position of the high end of the field (15 or less)
+ *  @param lo the bit position of the low end of the field (hi &gt;= lo)
+ *  @param fields where the value of each field is stored
+ */
+static inline void getFields (const uint16_t* words, int count, int hi, int lo,
+                              uint16_t* fields) {
+  int i = 0;
+
+#if defined(__SSE2__)
+  /* move the field to the top, then shift it down */
+  __m128i up   = _mm_cvtsi32_si128(15 - hi);
+  __m128i down = _mm_cvtsi32_si128(15 - hi + lo);
+
+  for (; i + 8 <= count; i += 8) {
+    __m128i v = _mm_sll_epi16(_mm_loadu_si128((const __m128i*) (words + i)),
+                              up);
+    _mm_storeu_si128((__m128i*) (fields + i), _mm_srl_epi16(v, down));
+  }
+#endif
+
+  for (; i < count; i++)
+    fields[i] = (uint16_t) (words[i] << (15 - hi)) >> (15 - hi + lo);
+}
+
+/** Extract the same signed field from each of an array of 16 bit words,
+ *  as <code>getFields()</code> does for unsigned fields.
+ *  @param words the source values
+ *  @param count the number of words
+ *  @param hi the bit position of the high end of the field (15 or less)
+ *  @param lo the bit position of the low end of the field (hi &gt;= lo)
+ *  @param fields where the value of each field is stored
+ */
+static inline void getSFields (const uint16_t* words, int count, int hi,
+                               int lo, int16_t* fields) {
+  int i = 0;
+
+#if defined(__SSE2__)
+  /* move the field to the top, then shift it down with its sign */
+  __m128i up   = _mm_cvtsi32_si128(15 - hi);
+  __m128i down = _mm_cvtsi32_si128(15 - hi + lo);
+
+  for (; i + 8 <= count; i += 8) {
+    __m128i v = _mm_sll_epi16(_mm_loadu_si128((const __m128i*) (words + i)),
+                              up);
+    _mm_storeu_si128((__m128i*) (fields + i), _mm_sra_epi16(v, down));
+  }
+#endif
+
+  for (; i < count; i++)
+    fields[i] = (int16_t) (uint16_t) (words[i] << (15 - hi)) >> (15 - hi + lo);
+}
+
+#endif /* __BITFIELD_H__ */
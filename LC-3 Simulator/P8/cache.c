@@ -0,0 +1,319 @@
+/** @file cache.c
+ *  @brief Implementation of the cache.h interface
+ *  @details Each cache keeps one tag and one time stamp per line, stored set
+ *  by set, so a lookup scans <code>ways</code> consecutive entries. The tag
+ *  is the full line number (address &gt;&gt; line shift), or -1 for an empty
+ *  line. All memory is allocated when a cache is configured.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache.h"
+#include "cycles.h"
+#include "symbol.h"
+
+#define CACHE_ADDRS   65536
+#define CACHE_PAGE    0x1000
+#define CACHE_LABELS  15     /* labels printed per cache */
+#define CACHE_SPAN    0x100  /* most addresses charged to one label */
+#define CACHE_DEVICES 0xFE00 /* device registers, never charged to a label */
+
+/* default geometry, used by cache_enable() */
+#define CACHE_DEF_WORDS   1024
+#define CACHE_DEF_WAYS    2
+#define CACHE_DEF_LINE    8
+#define CACHE_DEF_PENALTY 10
+
+typedef struct cache {
+  unsigned       words, ways, lineWords, penalty;
+  cache_policy_t policy;
+  int            lineShift;     /* log2(lineWords)           */
+  unsigned       setMask;       /* sets - 1                  */
+  int*           tag;           /* line number or -1         */
+  uint64_t*      stamp;         /* last use (LRU)/fill (FIFO)*/
+  uint64_t       clock;         /* source of time stamps     */
+  uint64_t*      hits;          /* per address               */
+  uint64_t*      misses;        /* per address               */
+} cache_t;
+
+bool cache_active = false;
+
+static const char* cache_names[CACHE_NUM_IDS]       = { "I", "D" };
+static const char* policy_names[CACHE_NUM_POLICIES] = {
+  "lru", "fifo", "random"
+};
+
+static cache_t  caches[CACHE_NUM_IDS];
+static unsigned cache_seed = 2463534242u;
+
+static bool is_power_of_2 (unsigned n) {
+  return (n != 0) && ((n & (n - 1)) == 0);
+}
+
+static int log_2 (unsigned n) {
+  int result = 0;
+  while (n >>= 1)
+    result++;
+  return result;
+}
+
+static void invalidate (cache_t* c) {
+  memset(c->tag, 0xFF, (c->words / c->lineWords) * sizeof(int));
+  memset(c->stamp, 0, (c->words / c->lineWords) * sizeof(uint64_t));
+  memset(c->hits, 0, CACHE_ADDRS * sizeof(uint64_t));
+  memset(c->misses, 0, CACHE_ADDRS * sizeof(uint64_t));
+  c->clock = 0;
+}
+
+int cache_config (cache_id_t id, unsigned words, unsigned ways,
+                  unsigned lineWords, cache_policy_t policy, unsigned penalty) {
+  if (! is_power_of_2(words) || ! is_power_of_2(ways)
+      || ! is_power_of_2(lineWords) || (words > CACHE_ADDRS)
+      || (ways * lineWords > words) || (policy >= CACHE_NUM_POLICIES))
+    return 1;
+
+  unsigned  lines  = words / lineWords;
+  int*      tag    = malloc(lines * sizeof(int));
+  uint64_t* stamp  = malloc(lines * sizeof(uint64_t));
+  uint64_t* hits   = malloc(CACHE_ADDRS * sizeof(uint64_t));
+  uint64_t* misses = malloc(CACHE_ADDRS * sizeof(uint64_t));
+
+  if (!tag || !stamp || !hits || !misses) {
+    free(tag);
+    free(stamp);
+    free(hits);
+    free(misses);
+    return 1;
+  }
+
+  cache_t* c = &caches[id];
+  free(c->tag);
+  free(c->stamp);
+  free(c->hits);
+  free(c->misses);
+
+  c->words     = words;
+  c->ways      = ways;
+  c->lineWords = lineWords;
+  c->penalty   = penalty;
+  c->policy    = policy;
+  c->lineShift = log_2(lineWords);
+  c->setMask   = lines / ways - 1;
+  c->tag       = tag;
+  c->stamp     = stamp;
+  c->hits      = hits;
+  c->misses    = misses;
+  invalidate(c);
+  return 0;
+}
+
+int cache_enable (bool on) {
+  if (on) {
+    for (int id = 0; id < CACHE_NUM_IDS; id++) {
+      if ((caches[id].tag == NULL)
+          && cache_config(id, CACHE_DEF_WORDS, CACHE_DEF_WAYS, CACHE_DEF_LINE,
+                          CACHE_LRU, CACHE_DEF_PENALTY))
+        return 1;
+    }
+  }
+  cache_active = on;
+  return 0;
+}
+
+void cache_reset (void) {
+  for (int id = 0; id < CACHE_NUM_IDS; id++) {
+    if (caches[id].tag)
+      invalidate(&caches[id]);
+  }
+}
+
+const char* cache_policy_name (cache_policy_t policy) {
+  return policy_names[policy];
+}
+
+int cache_find_policy (const char* name) {
+  for (int p = 0; p < CACHE_NUM_POLICIES; p++) {
+    if (strcmp(name, policy_names[p]) == 0)
+      return p;
+  }
+  return -1;
+}
+
+static void cache_access (cache_t* c, LC3_WORD addr) {
+  int       line   = addr >> c->lineShift;
+  unsigned  base   = (line & c->setMask) * c->ways;
+  int*      tag    = c->tag + base;
+  uint64_t* stamp  = c->stamp + base;
+  unsigned  victim = 0;
+
+  c->clock++;
+  for (unsigned w = 0; w < c->ways; w++) {
+    if (tag[w] == line) {
+      if (c->policy == CACHE_LRU)
+        stamp[w] = c->clock;
+      c->hits[addr]++;
+      return;
+    }
+  }
+
+  /* miss: use an empty line, else the one the policy chooses */
+  c->misses[addr]++;
+  if (cycles_active)
+    cycles_stall(c->penalty);
+
+  if (c->policy == CACHE_RANDOM) {
+    cache_seed ^= cache_seed << 13; /* xorshift32 */
+    cache_seed ^= cache_seed >> 17;
+    cache_seed ^= cache_seed << 5;
+    victim = cache_seed & (c->ways - 1);
+  }
+  for (unsigned w = 0; w < c->ways; w++) {
+    if (tag[w] < 0) {
+      victim = w;
+      break;
+    }
+    if ((c->policy != CACHE_RANDOM) && (stamp[w] < stamp[victim]))
+      victim = w;
+  }
+
+  tag[victim]   = line;
+  stamp[victim] = c->clock;
+}
+
+void cache_fetch (LC3_WORD addr) {
+  cache_access(&caches[CACHE_I], addr);
+}
+
+void cache_data (LC3_WORD addr) {
+  cache_access(&caches[CACHE_D], addr);
+}
+
+static void print_rate (FILE* f, unsigned long long hits,
+                        unsigned long long misses) {
+  unsigned long long total = hits + misses;
+  fprintf(f, "%12llu %10llu %7.2f%%\n", total, misses,
+          total ? 100.0 * misses / total : 0.0);
+}
+
+/* per label counts, so they can be sorted by misses */
+typedef struct label_rate {
+  const char*        name;
+  unsigned long long hits, misses;
+} label_rate_t;
+
+static int by_misses (const void* vp1, const void* vp2) {
+  const label_rate_t* r1 = vp1;
+  const label_rate_t* r2 = vp2;
+  return (r1->misses < r2->misses) - (r1->misses > r2->misses);
+}
+
+/* the labels, collected with symbol_iterate() */
+typedef struct label_list {
+  symbol_t** syms;
+  int        num, capacity;
+} label_list_t;
+
+static void collect (symbol_t* sym, void* data) {
+  label_list_t* list = data;
+
+  if (list->num == list->capacity) {
+    int        capacity = list->capacity ? 2 * list->capacity : 64;
+    symbol_t** syms     = realloc(list->syms, capacity * sizeof(symbol_t*));
+    if (syms == NULL)
+      return;
+    list->syms     = syms;
+    list->capacity = capacity;
+  }
+  list->syms[list->num++] = sym;
+}
+
+static int by_addr (const void* vp1, const void* vp2) {
+  const symbol_t* s1 = *(symbol_t* const*) vp1;
+  const symbol_t* s2 = *(symbol_t* const*) vp2;
+  return s1->addr - s2->addr;
+}
+
+static void report_labels (FILE* f, const cache_t* c, sym_table_t* symTab) {
+  label_list_t  list = { NULL, 0, 0 };
+  label_rate_t* rates;
+
+  symbol_iterate(symTab, collect, &list);
+  symbol_t** syms = list.syms;
+  int        num  = list.num;
+
+  if ((num == 0) || ((rates = calloc(num, sizeof(label_rate_t))) == NULL)) {
+    free(syms);
+    return;
+  }
+  qsort(syms, num, sizeof(symbol_t*), by_addr);
+
+  /* each label covers the addresses up to the next label, but no more than
+   * CACHE_SPAN of them, so code and data without a label of their own (the
+   * user program after the last OS label, say) are not charged to it
+   */
+  for (int i = 0; i < num; i++) {
+    int end = (i + 1 < num) ? syms[i + 1]->addr : CACHE_DEVICES;
+    if (end > syms[i]->addr + CACHE_SPAN)
+      end = syms[i]->addr + CACHE_SPAN;
+    if (end > CACHE_DEVICES)
+      end = CACHE_DEVICES;
+    rates[i].name = syms[i]->name;
+    for (int addr = syms[i]->addr; addr < end; addr++) {
+      rates[i].hits   += c->hits[addr];
+      rates[i].misses += c->misses[addr];
+    }
+  }
+
+  qsort(rates, num, sizeof(label_rate_t), by_misses);
+  for (int i = 0; (i < num) && (i < CACHE_LABELS) && rates[i].misses; i++) {
+    fprintf(f, "  %-20s", rates[i].name);
+    print_rate(f, rates[i].hits, rates[i].misses);
+  }
+
+  free(rates);
+  free(syms);
+}
+
+void cache_report (FILE* f, sym_table_t* symTab) {
+  for (int id = 0; id < CACHE_NUM_IDS; id++) {
+    const cache_t* c = &caches[id];
+
+    if (c->tag == NULL) {
+      fprintf(f, "%s-cache not configured\n", cache_names[id]);
+      continue;
+    }
+
+    unsigned long long hits = 0, misses = 0;
+    unsigned long long pageHits[CACHE_ADDRS / CACHE_PAGE]   = { 0 };
+    unsigned long long pageMisses[CACHE_ADDRS / CACHE_PAGE] = { 0 };
+
+    for (int addr = 0; addr < CACHE_ADDRS; addr++) {
+      pageHits[addr / CACHE_PAGE]   += c->hits[addr];
+      pageMisses[addr / CACHE_PAGE] += c->misses[addr];
+    }
+    for (int p = 0; p < CACHE_ADDRS / CACHE_PAGE; p++) {
+      hits   += pageHits[p];
+      misses += pageMisses[p];
+    }
+
+    fprintf(f, "%s-cache: %u words, %u-way, %u word lines, %s, "
+            "miss penalty %u\n", cache_names[id], c->words, c->ways,
+            c->lineWords, policy_names[c->policy], c->penalty);
+    fprintf(f, "  %-20s%12s %10s %8s\n", "", "accesses", "misses", "rate");
+    fprintf(f, "  %-20s", "total");
+    print_rate(f, hits, misses);
+
+    for (int p = 0; p < CACHE_ADDRS / CACHE_PAGE; p++) {
+      if (pageHits[p] || pageMisses[p]) {
+        fprintf(f, "  page x%04X%9s", p * CACHE_PAGE, "");
+        print_rate(f, pageHits[p], pageMisses[p]);
+      }
+    }
+
+    if (symTab && misses)
+      report_labels(f, c, symTab);
+    fputs("\n", f);
+  }
+}
@@ -0,0 +1,97 @@
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+/** @file cache.h
+ *  @brief interface to the L1 instruction/data cache model
+ *  @details While the model is on, the control logic (logic.c) reports every
+ *  instruction fetch to the instruction cache and every data read or write
+ *  (hardware_memory_enable()) to the data cache. The model only tracks
+ *  which lines are present; memory itself is unchanged. Writes allocate a
+ *  line like reads do, and write-back traffic is not modeled.
+ *  <p>
+ *  Sizes are in LC3 words. The size, number of ways and line size must be
+ *  powers of two, so that the set and tag are found with a shift and a mask.
+ *  Each miss adds the configured penalty to the cycle counter (cycles.h)
+ *  when it is on.
+ *  <p>
+ *  Hits and misses are also counted per address, so that the report can
+ *  show them per 4K page and per label without slowing down each access.
+ *  A label is charged with the accesses from its address up to the next
+ *  label, at most 256 words. Addresses further from a label, and the device
+ *  registers (xFE00 and up), are counted only in the page and total rates.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "lc3.h"
+
+/** The two caches */
+typedef enum cache_id {
+  CACHE_I,      /**< instruction cache, fed by fetches   */
+  CACHE_D,      /**< data cache, fed by loads and stores */
+  CACHE_NUM_IDS
+} cache_id_t;
+
+/** Which line of a set is replaced on a miss */
+typedef enum cache_policy {
+  CACHE_LRU,    /**< least recently used                 */
+  CACHE_FIFO,   /**< oldest line filled                  */
+  CACHE_RANDOM, /**< any line                            */
+  CACHE_NUM_POLICIES
+} cache_policy_t;
+
+/** True while the model is on. Tested by the control logic before reporting
+ *  an access, so the model costs nothing when it is off.
+ */
+extern bool cache_active;
+
+/** Configure one of the caches. Its contents and counts are cleared.
+ *  @param id - the cache to configure
+ *  @param words - total size
+ *  @param ways - lines per set (associativity)
+ *  @param lineWords - size of a line
+ *  @param policy - replacement policy
+ *  @param penalty - cycles added for each miss
+ *  @return 0 on success, non-zero if the geometry is invalid or memory
+ *  cannot be allocated (the previous configuration is kept)
+ */
+int cache_config (cache_id_t id, unsigned words, unsigned ways,
+                  unsigned lineWords, cache_policy_t policy, unsigned penalty);
+
+/** Turn the model on (configuring any cache not yet configured with the
+ *  default geometry) or off.
+ *  @return 0 on success, non-zero if memory cannot be allocated
+ */
+int cache_enable (bool on);
+
+/** Invalidate both caches and clear all counts */
+void cache_reset (void);
+
+/** Return the name of a policy (e.g. "lru") */
+const char* cache_policy_name (cache_policy_t policy);
+
+/** Find a policy by name
+ *  @param name - the name as returned by cache_policy_name()
+ *  @return the policy, or -1 if there is no such name
+ */
+int cache_find_policy (const char* name);
+
+/** Report an instruction fetch
+ *  @param addr - address fetched
+ */
+void cache_fetch (LC3_WORD addr);
+
+/** Report a data read or write
+ *  @param addr - address accessed
+ */
+void cache_data (LC3_WORD addr);
+
+/** Print the configuration and hit/miss rates of both caches, overall,
+ *  per 4K page and per label.
+ *  @param f - where to print
+ *  @param symTab - labels used for the per label rates (may be NULL)
+ */
+void cache_report (FILE* f, sym_table_t* symTab);
+
+#endif /* __CACHE_H__ */
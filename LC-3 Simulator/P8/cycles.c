@@ -0,0 +1,145 @@
+/** @file cycles.c
+ *  @brief Implementation of the cycles.h interface
+ *  @details The cycles of the instruction in progress are kept in
+ *  <code>cyc_inst</code> and credited to its opcode when the next one is
+ *  fetched, since the opcode is not known until the fetch has completed.
+ */
+
+#include <string.h>
+
+#include "cycles.h"
+
+#define CYC_NUM_OPS 16
+
+bool cycles_active = false;
+
+static const char* cyc_names[CYC_NUM_KINDS] = {
+  "gate", "load", "set", "decode", "read", "write"
+};
+
+static unsigned cyc_cost[CYC_NUM_KINDS] = {
+  0, /* gate   - the bus is driven in the same cycle it is latched */
+  1, /* load   */
+  0, /* set    - the PC/CC change alongside another step          */
+  1, /* decode */
+  1, /* read   */
+  1  /* write  */
+};
+
+static unsigned long long cyc_total;                /* all cycles         */
+static unsigned long long cyc_inst;                 /* current instruction*/
+static int                cyc_op = -1;              /* its opcode         */
+static unsigned long long cyc_opCycles[CYC_NUM_OPS];/* retired, by opcode */
+static unsigned long long cyc_opCount[CYC_NUM_OPS]; /* instructions       */
+
+void cycles_enable (bool on) {
+  cycles_active = on;
+}
+
+void cycles_reset (void) {
+  cyc_total = 0;
+  cyc_inst  = 0;
+  cyc_op    = -1;
+  memset(cyc_opCycles, 0, sizeof(cyc_opCycles));
+  memset(cyc_opCount, 0, sizeof(cyc_opCount));
+}
+
+const char* cycles_kind_name (cycle_kind_t kind) {
+  return cyc_names[kind];
+}
+
+int cycles_find_kind (const char* name) {
+  for (int k = 0; k < CYC_NUM_KINDS; k++) {
+    if (strcmp(name, cyc_names[k]) == 0)
+      return k;
+  }
+  return -1;
+}
+
+unsigned cycles_get_cost (cycle_kind_t kind) {
+  return cyc_cost[kind];
+}
+
+void cycles_set_cost (cycle_kind_t kind, unsigned cost) {
+  cyc_cost[kind] = cost;
+}
+
+/* credit the instruction in progress to its opcode */
+static void retire (void) {
+  if (cyc_op >= 0) {
+    cyc_opCycles[cyc_op] += cyc_inst;
+    cyc_opCount[cyc_op]++;
+  }
+  cyc_inst = 0;
+  cyc_op   = -1;
+}
+
+void cycles_fetch (void) {
+  retire();
+}
+
+void cycles_decode (int opcode) {
+  cyc_op = opcode & 0xF;
+  cycles_charge(CYC_DECODE);
+}
+
+void cycles_charge (cycle_kind_t kind) {
+  cyc_inst  += cyc_cost[kind];
+  cyc_total += cyc_cost[kind];
+}
+
+void cycles_stall (unsigned cycles) {
+  cyc_inst  += cycles;
+  cyc_total += cycles;
+}
+
+unsigned long long cycles_total (void) {
+  return cyc_total;
+}
+
+/* the instruction in progress has executed when the simulator stops, so it
+ * is included in reports without being retired
+ */
+static unsigned long long op_cycles (int op) {
+  return cyc_opCycles[op] + ((op == cyc_op) ? cyc_inst : 0);
+}
+
+static unsigned long long op_count (int op) {
+  return cyc_opCount[op] + ((op == cyc_op) ? 1 : 0);
+}
+
+void cycles_summary (FILE* f) {
+  unsigned long long insts = 0;
+
+  for (int op = 0; op < CYC_NUM_OPS; op++)
+    insts += op_count(op);
+
+  fprintf(f, "%llu cycles, %llu instructions", cyc_total, insts);
+  if (insts)
+    fprintf(f, ", CPI %.2f", (double) cyc_total / insts);
+  fputs("\n", f);
+}
+
+void cycles_report (FILE* f) {
+  cycles_summary(f);
+
+  fputs("\ncost:", f);
+  for (int k = 0; k < CYC_NUM_KINDS; k++)
+    fprintf(f, " %s=%u", cyc_names[k], cyc_cost[k]);
+  fputs("\n", f);
+
+  if (cyc_total == 0)
+    return;
+
+  fprintf(f, "\n%-10s %12s %14s %6s %6s\n", "opcode", "count", "cycles",
+          "CPI", "%");
+  for (int op = 0; op < CYC_NUM_OPS; op++) {
+    unsigned long long count  = op_count(op);
+    unsigned long long cycles = op_cycles(op);
+
+    if (count)
+      fprintf(f, "%-10s %12llu %14llu %6.2f %6.1f\n",
+              lc3_get_opcode_name((opcode_t) op), count, cycles,
+              (double) cycles / count, 100.0 * cycles / cyc_total);
+  }
+}
@@ -0,0 +1,92 @@
+#ifndef __CYCLES_H__
+#define __CYCLES_H__
+
+/** @file cycles.h
+ *  @brief interface to the modeled clock cycle counter
+ *  @details While the counter is on, every micro-step performed by the
+ *  control logic (logic.c) charges cycles from a cost table: driving the bus
+ *  (gate), latching a register (load), setting the PC or condition codes
+ *  (set), decoding and accessing memory (read/write, the memory latency).
+ *  Cycles are accumulated in total and per opcode, so two versions of an
+ *  algorithm can be compared by modeled cycles instead of instruction counts.
+ *  <p>
+ *  The default costs follow the LC3 state machine: fetch is three cycles
+ *  (load MAR, read memory, load IR), decode is one, and e.g. ADD takes one
+ *  more (load the destination register) and LD three more.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "lc3.h"
+
+/** The kinds of micro-step that are charged */
+typedef enum cycle_kind {
+  CYC_GATE,    /**< a value is put on the bus                     */
+  CYC_LOAD,    /**< a register (MAR, MDR, IR, R0-R7, PSR) latched */
+  CYC_SET,     /**< the PC or condition codes are set             */
+  CYC_DECODE,  /**< an instruction is decoded                     */
+  CYC_READ,    /**< memory read latency                           */
+  CYC_WRITE,   /**< memory write latency                          */
+  CYC_NUM_KINDS
+} cycle_kind_t;
+
+/** True while cycles are being counted. Tested by the control logic before
+ *  charging, so the counter costs nothing when it is off.
+ */
+extern bool cycles_active;
+
+/** Start (or stop) counting. Turning the counter on does not clear it. */
+void cycles_enable (bool on);
+
+/** Clear all counts */
+void cycles_reset (void);
+
+/** Return the name of a kind of micro-step (e.g. "load") */
+const char* cycles_kind_name (cycle_kind_t kind);
+
+/** Find a kind of micro-step by name
+ *  @param name - the name as returned by cycles_kind_name()
+ *  @return the kind, or -1 if there is no such name
+ */
+int cycles_find_kind (const char* name);
+
+/** Return the cost of a kind of micro-step */
+unsigned cycles_get_cost (cycle_kind_t kind);
+
+/** Set the cost of a kind of micro-step
+ *  @param kind - the micro-step
+ *  @param cost - cycles charged each time it is performed
+ */
+void cycles_set_cost (cycle_kind_t kind, unsigned cost);
+
+/** Report the start of an instruction (before the fetch). The cycles of the
+ *  previous instruction are credited to its opcode.
+ */
+void cycles_fetch (void);
+
+/** Report the decode of an instruction. Charges the decode cost.
+ *  @param opcode - opcode (0-15) of the instruction being executed
+ */
+void cycles_decode (int opcode);
+
+/** Charge one micro-step
+ *  @param kind - the micro-step performed
+ */
+void cycles_charge (cycle_kind_t kind);
+
+/** Charge extra cycles (e.g. a stall) to the current instruction
+ *  @param cycles - number of cycles to add
+ */
+void cycles_stall (unsigned cycles);
+
+/** Return the total number of cycles counted */
+unsigned long long cycles_total (void);
+
+/** Print a one line summary: cycles, instructions and CPI */
+void cycles_summary (FILE* f);
+
+/** Print the summary, the cost table and cycles broken down by opcode */
+void cycles_report (FILE* f);
+
+#endif /* __CYCLES_H__ */
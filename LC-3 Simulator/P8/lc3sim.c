@@ -26,6 +26,9 @@
  * programming assignments.
  */
 
+/* fileno, fdopen, strcasecmp and the socket calls are POSIX, not C11 */
+#define _DEFAULT_SOURCE
+
 #include <ctype.h>
 #include <string.h>
 #include <stdio.h>
@@ -71,11 +74,16 @@
 
 /* additional files added by fritz */
 #include "Debug.h"
+#include "cache.h"
+#include "cycles.h"
 #include "symbol.h"
 #include "lc3.h"
 #include "hardware.h"
 #include "logic.h"
 #include "install.h"
+#include "memstats.h"
+#include "trace.h"
+#include "undo.h"
 
 typedef enum reg_num_t reg_num_t;
 
@@ -107,6 +115,7 @@ enum inst_flag_t {
 #define MAX_SCRIPT_DEPTH    10    /* prevent infinite recursion in scripts */
 #define MAX_FINISH_DEPTH 10000000 /* avoid waiting to finish subroutine    */
 				  /* that recurses infinitely              */
+#define DEFAULT_UNDO_MB     64    /* memory for reverse execution log      */
 
 #define TOO_MANY_ARGS     "WARNING: Ignoring excess arguments."
 #define BAD_ADDRESS       \
@@ -124,11 +133,20 @@ enum bpt_type_t {BPT_NONE, BPT_USER};
 
 extern char* strdup(const char* s);
 
+/* register and memory access through the bus, in logic2.o of P8.a */
+int      logic_read_reg (int regNum);
+void     logic_write_reg (int regNum, LC3_WORD value);
+LC3_WORD logic_read_memory (LC3_WORD addr);
+void     logic_write_memory (LC3_WORD addr, LC3_WORD value);
+
 static int quiet          = 0; /* fritz */
 static int run_os_on_init = 1; /* fritz */
 
 static int launch_gui_connection ();
 static char* simple_readline (const char* prompt);
+#if defined(USE_READLINE)
+static char* complete_label (const char* text, int state);
+#endif
 
 static void init_machine ();
 static void print_register (int which);
@@ -138,6 +156,7 @@ static void show_state_if_stop_visible ();
 static int read_obj_file (const char* filename, int* startp, int* endp);
 static int read_sym_file (const UNSIGNED char* filename);
 static void squash_symbols (int addr_s, int addr_e);
+static int find_labels (const char* prefix, symbol_t* const** first);
 static int execute_instruction ();
 static void disassemble_one (int addr);
 static void disassemble (int addr_s, int addr_e);
@@ -157,7 +176,9 @@ static void gui_stop_and_dump ();
 static int str2reg (const char* name);
 
 static void cmd_break     (const UNSIGNED char* args);
+static void cmd_cache     (const UNSIGNED char* args);
 static void cmd_continue  (const UNSIGNED char* args);
+static void cmd_cycles    (const UNSIGNED char* args);
 static void cmd_dump      (const UNSIGNED char* args);
 static void cmd_execute   (const UNSIGNED char* args);
 static void cmd_file      (const UNSIGNED char* args);
@@ -171,7 +192,13 @@ static void cmd_printregs (const UNSIGNED char* args);
 static void cmd_quit      (const UNSIGNED char* args);
 static void cmd_register  (const UNSIGNED char* args);
 static void cmd_reset     (const UNSIGNED char* args);
+static void cmd_reverse   (const UNSIGNED char* args);
+static void cmd_rcontinue (const UNSIGNED char* args);
+static void cmd_rnext     (const UNSIGNED char* args);
+static void cmd_rstep     (const UNSIGNED char* args);
+static void cmd_stats     (const UNSIGNED char* args);
 static void cmd_step      (const UNSIGNED char* args);
+static void cmd_trace     (const UNSIGNED char* args);
 static void cmd_translate (const UNSIGNED char* args);
 static void cmd_lc3_stop  (const UNSIGNED char* args);
 
@@ -199,6 +226,8 @@ struct command_t {
 static const struct command_t command[] = {
     {"break",     1, cmd_break,     CMD_FLAG_NONE      },
     {"continue",  1, cmd_continue,  CMD_FLAG_REPEATABLE},
+    {"cache",     2, cmd_cache,     CMD_FLAG_NONE      },
+    {"cycles",    2, cmd_cycles,    CMD_FLAG_NONE      },
     {"dump",      1, cmd_dump,      CMD_FLAG_LIST_TYPE },
     {"execute",   1, cmd_execute,   CMD_FLAG_NONE      },
     {"file",      1, cmd_file,      CMD_FLAG_NONE      },
@@ -212,7 +241,16 @@ static const struct command_t command[] = {
     {"quit",      4, cmd_quit,      CMD_FLAG_NONE      },
     {"register",  1, cmd_register,  CMD_FLAG_NONE      },
     {"reset",     5, cmd_reset,     CMD_FLAG_NONE      },
+    {"reverse",   7, cmd_reverse,   CMD_FLAG_NONE      },
+    {"reverse-continue", 9, cmd_rcontinue, CMD_FLAG_REPEATABLE},
+    {"reverse-next",     9, cmd_rnext,     CMD_FLAG_REPEATABLE},
+    {"reverse-step",     9, cmd_rstep,     CMD_FLAG_REPEATABLE},
+    {"rc",        2, cmd_rcontinue, CMD_FLAG_REPEATABLE},
+    {"rn",        2, cmd_rnext,     CMD_FLAG_REPEATABLE},
+    {"rs",        2, cmd_rstep,     CMD_FLAG_REPEATABLE},
+    {"stats",     5, cmd_stats,     CMD_FLAG_NONE      },
     {"step",      1, cmd_step,      CMD_FLAG_REPEATABLE},
+    {"trace",     5, cmd_trace,     CMD_FLAG_NONE      },
     {"translate", 1, cmd_translate, CMD_FLAG_NONE      },
     {"x",         1, cmd_lc3_stop,  CMD_FLAG_GUI_ONLY  },
     {NULL,        0, NULL,          CMD_FLAG_NONE      }
@@ -330,18 +368,22 @@ static void setReg (int i, LC3_WORD val) {
 }
 
 int execute_instruction () {
-  instruction_t inst;
-
-  if (hardware_step(&inst) != 0) {
-    hardware_set_PC(inst.addr);
-    show_error("Illegal instruction at x%04X", inst.addr);
+  union {
+    instruction_t inst;
+    char          room[68]; /* hardware_step() in P8.a clears 68 bytes */
+  } step;
+  instruction_t* inst = &step.inst;
+
+  if (hardware_step(inst) != 0) {
+    hardware_set_PC(inst->addr);
+    show_error("Illegal instruction at x%04X", inst->addr);
     return 0;
   }
 
-  if ((inst.opcode == OP_JSR_JSRR) || (inst.opcode == OP_TRAP)) {
+  if ((inst->opcode == OP_JSR_JSRR) || (inst->opcode == OP_TRAP)) {
     last_flags = FLG_SUBROUTINE;
   }
-  else if ((inst.opcode == OP_JMP_RET) && (inst.SR1 == 7)) {
+  else if ((inst->opcode == OP_JMP_RET) && (inst->SR1 == 7)) {
     last_flags |= FLG_RETURN;
   }
   else {
@@ -405,12 +447,12 @@ void halt_lc3 (int sig) {
 
 
 static int launch_gui_connection () {
-    u_short port;
+    unsigned short port;
     int fd;                   /* server socket file descriptor   */
     struct sockaddr_in addr;  /* server socket address           */
 
     /* wait for the GUI to tell us the portfor the LC-3 console socket */
-    if (fscanf (sim_in, "%hd", &port) != 1)
+    if (fscanf (sim_in, "%hu", &port) != 1)
         return -1;
 
     /* don't buffer output to GUI */
@@ -498,6 +540,21 @@ static char* simple_readline (const char* prompt) {
 }
 
 
+#if defined(USE_READLINE)
+/* readline completion: the labels starting with the text, one per call */
+static char* complete_label (const char* text, int state) {
+    static symbol_t* const* first;
+    static int num, next;
+
+    if (state == 0) {
+	num = find_labels (text, &first);
+	next = 0;
+    }
+    return (next < num) ? strdup (first[next++]->name) : NULL;
+}
+#endif
+
+
 static void command_loop () {
     int cword_len;
     UNSIGNED char* cmd = NULL;
@@ -614,6 +671,7 @@ int main (int argc, const char* argv[]) {
 	gui_mode = 0;
 #if defined(USE_READLINE)
 	lc3readline = readline;
+	rl_completion_entry_function = complete_label;
 #endif
     }
 
@@ -762,6 +820,58 @@ static void squash_symbols (int addr_s, int addr_e)
     }
 }
 
+/* labels found by find_labels: the symbol library in P8.a has no prefix
+   search, so the matches are collected with symbol_iterate and sorted */
+typedef struct label_list_t {
+    const char* prefix;
+    size_t      len;
+    int         num;
+    int         max;
+    symbol_t**  syms;
+} label_list_t;
+
+static void add_label_if_match (symbol_t* sym, void* data)
+{
+    label_list_t* list = data;
+
+    if (strncasecmp (sym->name, list->prefix, list->len) != 0)
+        return;
+    if (list->num == list->max) {
+	symbol_t** bigger;
+	int max = (list->max == 0) ? 64 : list->max * 2;
+
+	if ((bigger = realloc (list->syms, max * sizeof (*bigger))) == NULL)
+	    return;
+	list->syms = bigger;
+	list->max = max;
+    }
+    list->syms[list->num++] = sym;
+}
+
+static int compare_labels (const void* a, const void* b)
+{
+    const symbol_t* sa = *(symbol_t* const*) a;
+    const symbol_t* sb = *(symbol_t* const*) b;
+    int cmp = strcasecmp (sa->name, sb->name);
+
+    return (cmp != 0) ? cmp : strcmp (sa->name, sb->name);
+}
+
+/* Find the labels starting with prefix (case insensitive), in alphabetical
+   order. The list is reused by the next call. */
+static int find_labels (const char* prefix, symbol_t* const** first)
+{
+    static label_list_t list;
+
+    list.prefix = prefix;
+    list.len = strlen (prefix);
+    list.num = 0;
+    symbol_iterate (lc3_sym_tab, add_label_if_match, &list);
+    qsort (list.syms, list.num, sizeof (*list.syms), compare_labels);
+    *first = list.syms;
+    return list.num;
+}
+
 void hardware_reset(void); /* fritz */
 
 static void 
@@ -770,6 +880,7 @@ init_machine ()
     in_init = 1;
 
     hardware_reset();
+    undo_clear();
     bzero (lc3_show_later, sizeof (lc3_show_later));
     symbol_reset(lc3_sym_tab);
     clear_all_breakpoints ();
@@ -941,6 +1052,9 @@ static void run_until_stopped () {
 
     while (!should_halt && execute_instruction ());
 
+    if (cycles_active && !gui_mode)
+	cycles_summary (stdout);
+
     if (!tty_fail) {
 	tio.c_lflag = old_lflag;
 	tio.c_cc[VMIN] = old_min;
@@ -1116,6 +1230,118 @@ static void cmd_continue (const UNSIGNED char* args) {
 }
 
 
+static void cmd_cache (const UNSIGNED char* args) {
+    UNSIGNED char opt[11], policy[11], trash[2];
+    unsigned words, ways, line, penalty = 10;
+    int num_args, opt_len, pol = CACHE_LRU;
+
+    num_args = sscanf (args, "%10s%u%u%u%10s%u%1s", opt, &words, &ways,
+		       &line, policy, &penalty, trash);
+
+    if (num_args < 1) {
+	cache_report (stdout, lc3_sym_tab);
+	return;
+    }
+
+    opt_len = strlen (opt);
+    if (strncasecmp (opt, "on", opt_len) == 0 && num_args == 1) {
+	if (cache_enable (1) != 0)
+	    show_error ("Not enough memory for the cache model.");
+	return;
+    }
+    if (strncasecmp (opt, "off", opt_len) == 0 && num_args == 1) {
+	cache_enable (0);
+	return;
+    }
+    if (strncasecmp (opt, "reset", opt_len) == 0 && num_args == 1) {
+	cache_reset ();
+	return;
+    }
+    if ((strcasecmp (opt, "i") == 0 || strcasecmp (opt, "d") == 0)
+        && num_args >= 4) {
+	if (num_args > 6)
+	    warn_too_many_args ();
+	if (num_args > 4 && (pol = cache_find_policy (policy)) < 0) {
+	    show_error ("Policies are lru, fifo and random.");
+	    return;
+	}
+	if (cache_config (tolower (opt[0]) == 'i' ? CACHE_I : CACHE_D, words,
+			  ways, line, pol, penalty) != 0)
+	    show_error ("Sizes must be powers of 2 and fit in memory.");
+	return;
+    }
+
+    printf ("cache options include:\n");
+    printf ("  cache                -- show hit/miss rates by page and "
+	    "label\n");
+    printf ("  cache on|off         -- start/stop the model (default "
+	    "1024 words,\n");
+    printf ("                          2-way, 8 word lines, lru, penalty "
+	    "10)\n");
+    printf ("  cache reset          -- empty the caches and clear the "
+	    "counts\n");
+    printf ("  cache i|d <words> <ways> <line> [lru|fifo|random [penalty]]\n");
+    printf ("                       -- configure the instruction/data "
+	    "cache\n");
+}
+
+
+static void cmd_cycles (const UNSIGNED char* args) {
+    UNSIGNED char opt[11], step[11], trash[2];
+    int num_args, opt_len, kind, value;
+
+    num_args = sscanf (args, "%10s%10s%d%1s", opt, step, &value, trash);
+
+    if (num_args < 1) {
+	cycles_report (stdout);
+	return;
+    }
+
+    opt_len = strlen (opt);
+    if (strncasecmp (opt, "on", opt_len) == 0 && num_args == 1) {
+	cycles_enable (1);
+	return;
+    }
+    if (strncasecmp (opt, "off", opt_len) == 0 && num_args == 1) {
+	cycles_enable (0);
+	return;
+    }
+    if (strncasecmp (opt, "reset", opt_len) == 0 && num_args == 1) {
+	cycles_reset ();
+	return;
+    }
+    if (strncasecmp (opt, "latency", opt_len) == 0 && num_args > 1) {
+	if (num_args > 2)
+	    warn_too_many_args ();
+	if (sscanf (step, "%d", &value) != 1 || value < 0) {
+	    show_error ("Latency must be a non-negative number of cycles.");
+	    return;
+	}
+	cycles_set_cost (CYC_READ, value);
+	cycles_set_cost (CYC_WRITE, value);
+	return;
+    }
+    if (strncasecmp (opt, "cost", opt_len) == 0 && num_args > 2) {
+	if (num_args > 3)
+	    warn_too_many_args ();
+	if ((kind = cycles_find_kind (step)) < 0 || value < 0) {
+	    show_error ("Steps are gate, load, set, decode, read and write.");
+	    return;
+	}
+	cycles_set_cost (kind, value);
+	return;
+    }
+
+    printf ("cycles options include:\n");
+    printf ("  cycles                 -- show cycles by opcode and the costs\n");
+    printf ("  cycles on|off          -- start/stop counting cycles\n");
+    printf ("  cycles reset           -- clear the counts\n");
+    printf ("  cycles cost <step> <n> -- cycles for gate, load, set, decode,\n");
+    printf ("                            read or write\n");
+    printf ("  cycles latency <n>     -- cycles for a memory read or write\n");
+}
+
+
 static void cmd_dump (const UNSIGNED char* args) {
     static int last_end = 0;
     int start, end;
@@ -1219,6 +1445,7 @@ static void cmd_file (const UNSIGNED char* args) {
     if (read_obj_file (buf, &start, &end) == -1) {
       return;
     }
+    undo_clear ();
     /* Success: reload same file next time machine is reset. */
     if (start_file != NULL)
     	free (start_file);
@@ -1274,8 +1501,22 @@ static void cmd_help (const UNSIGNED char* args) {
     printf ("step                  -- execute one step (into "
     	    "subroutine/trap)\n\n");
 
+    printf ("reverse on [MB]|off   -- record execution so it can be "
+	    "undone\n");
+    printf ("reverse-continue (rc) -- run backwards to a breakpoint\n");
+    printf ("reverse-next     (rn) -- undo one instruction (full "
+	    "subroutine/trap)\n");
+    printf ("reverse-step     (rs) -- undo one instruction\n\n");
+
+    printf ("cache [on|off|reset]  -- show/control the L1 cache model\n");
+    printf ("cache i|d <words> <ways> <line> [policy [penalty]] -- "
+	    "configure a cache\n");
+    printf ("cycles [on|off|reset] -- show/control modeled clock cycles\n");
+    printf ("cycles cost <step> <n> -- set cycles charged for a micro-step\n");
+    printf ("cycles latency <n>    -- set memory read/write latency\n\n");
+
     printf ("list ...              -- list instructions at the PC, an "
-    	    "address, a label\n");
+    	    "address, a label, labels matching <prefix>*\n");
     printf ("dump ...              -- dump memory at the PC, an address, "
     	    "a label\n");
     printf ("translate <addr>      -- show the value of a label and print the "
@@ -1290,6 +1531,17 @@ static void cmd_help (const UNSIGNED char* args) {
 
     printf ("execute <file name>   -- execute a script file\n\n");
 
+    printf ("trace start <file>    -- record executed instructions to a "
+	    "file\n");
+    printf ("trace stop            -- stop recording (view with "
+	    "lc3trace)\n\n");
+
+    printf ("stats memory          -- show memory access counts and R6 "
+	    "range\n");
+    printf ("stats dump <file>     -- write memory access heatmap to a "
+	    "file\n");
+    printf ("stats reset           -- clear memory access counts\n\n");
+
     printf ("reset                 -- reset LC-3 and reload last file\n\n");
 
     printf ("quit                  -- quit the simulator\n\n");
@@ -1405,7 +1657,23 @@ success:
 
 static void cmd_list (const UNSIGNED char* args) {
     static int last_end = 0;
-    int start, end;
+    int start, end, len;
+    UNSIGNED char pattern[81], trash[2];
+
+    /* list <prefix>* -- the first instruction of each matching label */
+    if (sscanf (args, "%80s%1s", pattern, trash) == 1 &&
+	pattern[(len = strlen (pattern)) - 1] == '*') {
+	symbol_t* const* first;
+	int i, num;
+
+	pattern[len - 1] = 0;
+	num = find_labels (pattern, &first);
+	if (num == 0 && !gui_mode)
+	    printf ("No labels start with \"%s\".\n", pattern);
+	for (i = 0; i < num; i++)
+	    disassemble_one (first[i]->addr);
+	return;
+    }
 
     if (parse_range (args, &start, &end, last_end, 10) == 0) {
 	disassemble (start, end);
@@ -1418,6 +1686,8 @@ static void cmd_list (const UNSIGNED char* args) {
     printf ("  list <addr>        -- list instructions starting from an "
 	    "address or label\n");
     printf ("  list <addr> <addr> -- list a range of instructions\n");
+    printf ("  list <prefix>*     -- list the instruction at each label "
+	    "starting with prefix\n");
     printf ("  list more          -- continue previous listing (or press "
 	    "<Enter>)\n");
 }
@@ -1428,6 +1698,7 @@ static void cmd_memory (const UNSIGNED char* args) {
 
     if (parse_range (args, &addr, &value, -1, -1) == 0) {
 	logic_write_memory (addr, value);
+	undo_clear ();
 	if (gui_mode) {
 	    printf ("TRANS x%04X x%04X\n", addr, value);
 	    disassemble_one (addr);
@@ -1625,6 +1896,7 @@ static void cmd_register (const UNSIGNED char* args) {
 	    if (strncasecmp (arg2, cc_val[value], len) == 0) {
                 LC3_WORD psr = get_PSR() & ~0x0E00;
 		setReg(R_PSR, (psr | (value + 1) << 9));
+		undo_clear ();
 		if (gui_mode)
 		    /* printing PSR prints both PSR and CC */
 		    print_register (R_PSR);
@@ -1645,6 +1917,7 @@ static void cmd_register (const UNSIGNED char* args) {
        value. */
     if ((value = parse_address (arg2)) != -1) {
 	setReg(rnum, value);
+	undo_clear ();
 	if (gui_mode)
 	    print_register (rnum);
 	else
@@ -1690,6 +1963,161 @@ static void cmd_reset (const UNSIGNED char* args) {
 }
 
 
+static void cmd_reverse (const UNSIGNED char* args) {
+    UNSIGNED char onoff[6], trash[2];
+    int num_args, mb = DEFAULT_UNDO_MB;
+
+    num_args = sscanf (args, "%5s%d%1s", onoff, &mb, trash);
+    if (num_args >= 1 && strcasecmp (onoff, "off") == 0) {
+	if (num_args > 1)
+	    warn_too_many_args ();
+	undo_disable ();
+	if (!gui_mode)
+	    printf ("Reverse execution disabled.\n");
+	return;
+    }
+    if (num_args >= 1 && strcasecmp (onoff, "on") == 0 && mb > 0) {
+	if (num_args > 2)
+	    warn_too_many_args ();
+	size_t insts = undo_enable ((size_t) mb << 20);
+	if (insts == 0)
+	    show_error ("Cannot allocate %d MB for reverse execution.", mb);
+	else if (!gui_mode)
+	    printf ("Will keep the last %zu instructions (%d MB).\n",
+		    insts, mb);
+	return;
+    }
+
+    printf ("syntax: reverse on [MB]|off\n");
+    printf ("  records execution so that reverse-step, reverse-next and\n");
+    printf ("  reverse-continue can undo it (default %d MB)\n",
+	    DEFAULT_UNDO_MB);
+}
+
+
+/* Undo one instruction, return 0 if nothing is left to undo. The flags
+   describe the undone instruction (used by reverse-next). */
+static int reverse_instruction (inst_flag_t* flags) {
+    LC3_WORD ir;
+    int opcode;
+
+    if (!undo_step (&ir)) {
+	if (!gui_mode)
+	    printf ("No more recorded execution to undo.\n");
+	return 0;
+    }
+
+    opcode = ir >> 12;
+    if (opcode == OP_JSR_JSRR || opcode == OP_TRAP)
+	*flags = FLG_SUBROUTINE;
+    else if (opcode == OP_JMP_RET && ((ir >> 6) & 7) == RETURN_ADDR_REG)
+	*flags = FLG_RETURN;
+    else
+	*flags = FLG_NONE;
+    return 1;
+}
+
+
+static int reverse_ready (const UNSIGNED char* args) {
+    no_args_allowed (args);
+    if (!undo_active) {
+	show_error ("Reverse execution is off (use 'reverse on').");
+	return 0;
+    }
+    return 1;
+}
+
+
+static void cmd_rcontinue (const UNSIGNED char* args) {
+    inst_flag_t flags;
+
+    if (!reverse_ready (args))
+	return;
+
+    while (reverse_instruction (&flags) &&
+           lc3_breakpoints[getPC()] != BPT_USER);
+
+    show_state_if_stop_visible ();
+}
+
+
+static void cmd_rnext (const UNSIGNED char* args) {
+    inst_flag_t flags;
+    int depth = 0;
+
+    if (!reverse_ready (args))
+	return;
+
+    /* Undoing a RET enters the subroutine from its end; keep going
+       until the matching JSR/JSRR/TRAP has been undone as well. */
+    while (reverse_instruction (&flags)) {
+	if (flags == FLG_RETURN)
+	    depth++;
+	else if (flags == FLG_SUBROUTINE && depth > 0)
+	    depth--;
+	if (depth == 0 || lc3_breakpoints[getPC()] == BPT_USER)
+	    break;
+    }
+
+    show_state_if_stop_visible ();
+}
+
+
+static void cmd_rstep (const UNSIGNED char* args) {
+    inst_flag_t flags;
+
+    if (!reverse_ready (args))
+	return;
+
+    reverse_instruction (&flags);
+    show_state_if_stop_visible ();
+}
+
+
+static void cmd_stats (const UNSIGNED char* args) {
+    UNSIGNED char opt[11], file[MAX_FILE_NAME_LEN], trash[2];
+    int num_args, opt_len;
+
+    /* 250 == MAX_FILE_NAME_LEN - 1 */
+    num_args = sscanf (args, "%10s%250s%1s", opt, file, trash);
+
+    if (num_args > 0) {
+	opt_len = strlen (opt);
+	if (!MEM_STATS_ENABLED) {
+	    show_error ("Memory statistics are not compiled in "
+			"(build with -DMEM_STATS).");
+	    return;
+	}
+	if (strncasecmp (opt, "memory", opt_len) == 0) {
+	    if (num_args > 1)
+		warn_too_many_args ();
+	    memstats_report (stdout, lc3_sym_tab);
+	    return;
+	}
+	if (strncasecmp (opt, "dump", opt_len) == 0 && num_args > 1) {
+	    if (num_args > 2)
+		warn_too_many_args ();
+	    if (memstats_dump (file) != 0)
+		show_error ("Cannot write heatmap file \"%s\".", file);
+	    else if (!gui_mode)
+		printf ("Wrote memory heatmap to \"%s\".\n", file);
+	    return;
+	}
+	if (strncasecmp (opt, "reset", opt_len) == 0) {
+	    if (num_args > 1)
+		warn_too_many_args ();
+	    memstats_reset ();
+	    return;
+	}
+    }
+
+    printf ("stats options include:\n");
+    printf ("  stats memory      -- show memory access counts and R6 range\n");
+    printf ("  stats dump <file> -- write memory access heatmap to a file\n");
+    printf ("  stats reset       -- clear memory access counts\n");
+}
+
+
 static void cmd_step (const UNSIGNED char* args) {
     no_args_allowed (args);
     flush_console_input ();
@@ -1699,6 +2127,42 @@ static void cmd_step (const UNSIGNED char* args) {
 }
 
 
+static void cmd_trace (const UNSIGNED char* args) {
+    UNSIGNED char opt[11], file[MAX_FILE_NAME_LEN], trash[2];
+    int num_args, opt_len;
+
+    /* 250 == MAX_FILE_NAME_LEN - 1 */
+    num_args = sscanf (args, "%10s%250s%1s", opt, file, trash);
+
+    if (num_args > 0) {
+	opt_len = strlen (opt);
+	if (strncasecmp (opt, "start", opt_len) == 0 && num_args > 1) {
+	    if (num_args > 2)
+		warn_too_many_args ();
+	    if (trace_start (file) != 0)
+		show_error ("Cannot record a trace to \"%s\".", file);
+	    else if (!gui_mode)
+		printf ("Recording execution trace to \"%s\".\n", file);
+	    return;
+	}
+	if (strncasecmp (opt, "stop", opt_len) == 0) {
+	    if (num_args > 1)
+		warn_too_many_args ();
+	    if (trace_stop () != 0)
+		show_error ("Cannot write the trace file; the trace is "
+			    "incomplete.");
+	    else if (!gui_mode)
+		printf ("Recorded %llu instructions.\n", trace_count ());
+	    return;
+	}
+    }
+
+    printf ("trace options include:\n");
+    printf ("  trace start <file> -- record executed instructions to a file\n");
+    printf ("  trace stop         -- stop recording and close the file\n");
+}
+
+
 static void cmd_translate (const UNSIGNED char* args) {
     UNSIGNED char arg1[81], trash[2];
     int num_args, value;
@@ -0,0 +1,177 @@
+/** @file lc3trace.c
+ *  @brief offline viewer for execution traces recorded by the simulator
+ *  @details Reads a trace file written by the simulator command
+ *  <code>trace start &lt;file&gt;</code> and either prints it or answers
+ *  simple questions about it. To understand the usage, run the program with
+ *  no arguments. Addresses use the LC3 syntax (e.g. <code>x4005</code>).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Debug.h"
+#include "trace.h"
+
+/** Print a usage statement describing how program is used, and exit */
+static void usage (void) {
+  puts("Usage: lc3trace dump   <trace> [first [count]] - print instructions");
+  puts("       lc3trace writer <trace> <addr>          - last write to addr");
+  puts("       lc3trace reg    <trace> <R0..R7>        - last write to reg");
+  puts("       lc3trace pc     <trace> <addr>          - executions of addr");
+  puts("       lc3trace stats  <trace>                 - summary of trace");
+  exit(1);
+}
+
+/** Convert an argument to a number, allowing LC3 hex (x4005) */
+static unsigned long long get_num (const char* s) {
+  if ((*s == 'x') || (*s == 'X'))
+    return strtoull(s + 1, NULL, 16);
+  if (*s == '#')
+    return strtoull(s + 1, NULL, 10);
+  return strtoull(s, NULL, 0);
+}
+
+static void print_rec (const trace_rec_t* rec, unsigned long long index) {
+  if (rec->flags & TRACE_CONT)
+    printf("%12s             ", "");
+  else
+    printf("%12llu x%04X x%04X", index, rec->pc, rec->ir);
+
+  if (rec->flags & TRACE_REG)
+    printf("  R%d=x%04X", rec->reg, rec->regVal);
+  if (rec->flags & TRACE_MEM)
+    printf("  M[x%04X]=x%04X", rec->memAddr, rec->memVal);
+  puts("");
+}
+
+static void dump (trace_reader_t* reader, unsigned long long first,
+                  unsigned long long count) {
+  trace_rec_t        rec;
+  unsigned long long index;
+
+  trace_seek(reader, first);
+  while (trace_next(reader, &rec, &index)) {
+    if (index < first)
+      continue;
+    if (index - first >= count)
+      break;
+    print_rec(&rec, index);
+  }
+}
+
+/** Find the last record matching reg (0..7) or memory address (addr) */
+static void last_writer (trace_reader_t* reader, int reg, int addr) {
+  trace_rec_t        rec, last;
+  unsigned long long index, lastIndex = 0;
+  int                found = 0;
+
+  while (trace_next(reader, &rec, &index)) {
+    if (   ((reg >= 0)  && (rec.flags & TRACE_REG) && (rec.reg == reg))
+        || ((addr >= 0) && (rec.flags & TRACE_MEM) && (rec.memAddr == addr))) {
+      last      = rec;
+      lastIndex = index;
+      found     = 1;
+    }
+  }
+
+  if (found)
+    print_rec(&last, lastIndex);
+  else
+    puts("never written");
+}
+
+static void executions (trace_reader_t* reader, int addr) {
+  trace_rec_t        rec;
+  unsigned long long index, count = 0, first = 0, last = 0;
+
+  while (trace_next(reader, &rec, &index)) {
+    if ((rec.pc == addr) && ! (rec.flags & TRACE_CONT)) {
+      if (count++ == 0)
+        first = index;
+      last = index;
+    }
+  }
+
+  printf("x%04X executed %llu times", addr, count);
+  if (count)
+    printf(" (first %llu, last %llu)", first, last);
+  puts("");
+}
+
+static void stats (trace_reader_t* reader, const char* fileName) {
+  trace_rec_t        rec;
+  unsigned long long index, insts = 0, regs = 0, mems = 0;
+  FILE*              f = fopen(fileName, "rb");
+  long               bytes = 0;
+
+  if (f) {
+    fseek(f, 0, SEEK_END);
+    bytes = ftell(f);
+    fclose(f);
+  }
+
+  while (trace_next(reader, &rec, &index)) {
+    if (! (rec.flags & TRACE_CONT))
+      insts++;
+    if (rec.flags & TRACE_REG)
+      regs++;
+    if (rec.flags & TRACE_MEM)
+      mems++;
+  }
+
+  printf("instructions:    %llu\n", insts);
+  printf("register writes: %llu\n", regs);
+  printf("memory writes:   %llu\n", mems);
+  printf("file size:       %ld bytes", bytes);
+  if (insts)
+    printf(" (%.2f bytes/instruction)", (double) bytes / insts);
+  puts("");
+}
+
+/** Entry point of the program
+ * @param argc count of arguments, will always be at least 1
+ * @param argv array of parameters to program argv[0] is the name of
+ * the program, so additional parameters will begin at index 1.
+ * @return 0 the Linux convention for success.
+ */
+int main (int argc, const char* argv[]) {
+  debugInit(&argc, argv);
+
+  if (argc < 3)
+    usage();
+
+  const char*     cmd    = argv[1];
+  trace_reader_t* reader = trace_open(argv[2]);
+
+  if (reader == NULL) {
+    printf("%s is not a trace file\n", argv[2]);
+    return 1;
+  }
+
+  if (strcmp(cmd, "dump") == 0) {
+    unsigned long long first = (argc > 3) ? get_num(argv[3]) : 0;
+    unsigned long long count = (argc > 4) ? get_num(argv[4]) : ~0ULL;
+    dump(reader, first, count);
+  }
+  else if ((strcmp(cmd, "writer") == 0) && (argc == 4)) {
+    last_writer(reader, -1, get_num(argv[3]) & 0xFFFF);
+  }
+  else if ((strcmp(cmd, "reg") == 0) && (argc == 4)
+           && ((argv[3][0] == 'R') || (argv[3][0] == 'r'))) {
+    last_writer(reader, atoi(argv[3] + 1) & 7, -1);
+  }
+  else if ((strcmp(cmd, "pc") == 0) && (argc == 4)) {
+    executions(reader, get_num(argv[3]) & 0xFFFF);
+  }
+  else if (strcmp(cmd, "stats") == 0) {
+    stats(reader, argv[2]);
+  }
+  else {
+    trace_close(reader);
+    usage();
+  }
+
+  trace_close(reader);
+  return 0;
+}
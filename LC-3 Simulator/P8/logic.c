@@ -11,12 +11,134 @@
 
 #include "lc3.h"
 #include "hardware.h"
+#include "cache.h"
+#include "cycles.h"
+#include "bitfield.h"
 #include "logic.h"
+#include "memstats.h"
+#include "trace.h"
+#include "undo.h"
+
+/* the fields of an LC3 instruction */
+FIELD_ACCESSORS(opcode,     15, 12, false)
+FIELD_ACCESSORS(DR,         11,  9, false)  /* also the nzp bits of BR   */
+FIELD_ACCESSORS(SR1,         8,  6, false)  /* also BaseR                */
+FIELD_ACCESSORS(SR2,         2,  0, false)
+FIELD_ACCESSORS(bit5,        5,  5, false)
+FIELD_ACCESSORS(bit11,      11, 11, false)
+FIELD_ACCESSORS(trapvect8,   7,  0, false)
+FIELD_ACCESSORS(imm5,        4,  0, true)
+FIELD_ACCESSORS(offset6,     5,  0, true)
+FIELD_ACCESSORS(PCoffset9,   8,  0, true)
+FIELD_ACCESSORS(PCoffset11, 10,  0, true)
 
 static int not_implemented() {
   return (! OK);
 }
 
+/* hardware.h has no accessors for the MAR/MDR, so the control logic keeps a
+ * copy of what it last loaded. These are reported to the execution trace,
+ * the undo log, the memory access counters and the cache model.
+ *
+ * Every micro-step goes through one of the functions below so that it can
+ * be charged to the cycle counter.
+ */
+static LC3_WORD logic_MAR;
+static LC3_WORD logic_MDR;
+
+static void gate_MDR (void) {
+  if (cycles_active)
+    cycles_charge(CYC_GATE);
+  hardware_gate_MDR();
+}
+
+static void gate_PC (void) {
+  if (cycles_active)
+    cycles_charge(CYC_GATE);
+  hardware_gate_PC();
+}
+
+static void gate_PSR (void) {
+  if (cycles_active)
+    cycles_charge(CYC_GATE);
+  hardware_gate_PSR();
+}
+
+static void gate_REG (int regNum) {
+  if (cycles_active)
+    cycles_charge(CYC_GATE);
+  hardware_gate_REG(regNum);
+}
+
+static void set_PC (LC3_WORD addr) {
+  if (cycles_active)
+    cycles_charge(CYC_SET);
+  hardware_set_PC(addr);
+}
+
+static void set_CC (int val) {
+  if (cycles_active)
+    cycles_charge(CYC_SET);
+  hardware_set_CC(val);
+}
+
+static void load_PSR (void) {
+  if (cycles_active)
+    cycles_charge(CYC_LOAD);
+  hardware_load_PSR();
+}
+
+static void load_MAR (void) {
+  if (cycles_active)
+    cycles_charge(CYC_LOAD);
+  logic_MAR = *lc3_BUS;
+  hardware_load_MAR();
+}
+
+static void load_MDR (void) {
+  if (cycles_active)
+    cycles_charge(CYC_LOAD);
+  logic_MDR = *lc3_BUS;
+  hardware_load_MDR();
+}
+
+static void load_REG (int regNum) {
+  if (cycles_active)
+    cycles_charge(CYC_LOAD);
+  if (MEM_STATS_ENABLED && (regNum == 6))
+    memstats_sp(*lc3_BUS);
+  if (undo_active)
+    undo_reg_write(regNum);
+  if (trace_active)
+    trace_reg_write(regNum, *lc3_BUS);
+  hardware_load_REG(regNum);
+}
+
+static void memory_enable (int rw) {
+  if (cycles_active)
+    cycles_charge(rw ? CYC_WRITE : CYC_READ);
+  if (cache_active)
+    cache_data(logic_MAR);
+  if (MEM_STATS_ENABLED)
+    memstats_access(rw, logic_MAR);
+  if (rw && undo_active)
+    undo_mem_write(logic_MAR, logic_MDR);
+  hardware_memory_enable(rw);
+  if (rw && trace_active)
+    trace_mem_write(logic_MAR, logic_MDR);
+}
+
+/* the read in the fetch cycle, counted separately from data reads */
+static void memory_fetch (void) {
+  if (cycles_active)
+    cycles_charge(CYC_READ);
+  if (cache_active)
+    cache_fetch(logic_MAR);
+  if (MEM_STATS_ENABLED)
+    memstats_fetch(logic_MAR);
+  hardware_memory_enable(0);
+}
+
 
 /* Instruction fetch, decode, and execution functions already provided. 
  *
@@ -31,16 +153,25 @@ static int not_implemented() {
  */
 
 void logic_fetch_instruction (instruction_t* inst) {
+  if (cycles_active)
+    cycles_fetch();
   /* clock cycle 1 */
-  hardware_gate_PC();             /* put PC onto BUS   */
-  hardware_load_MAR();            /* load MAR from BUS */
-  hardware_set_PC(*lc3_BUS+1);    /* increment PC      */
+  gate_PC();                      /* put PC onto BUS   */
+  load_MAR();                     /* load MAR from BUS */
   inst->addr = *lc3_BUS;          /* save PC for inst  */
+  set_PC(*lc3_BUS+1);             /* increment PC      */
   /* clock cycle 2 */
-  hardware_memory_enable(0);      /* read memory       */
+  memory_fetch();                 /* read memory       */
   /* clock cycle 3 */
-  hardware_gate_MDR();            /* put MDR on BUS    */
+  gate_MDR();                     /* put MDR on BUS    */
   inst->bits = *lc3_BUS;          /* load IR from BUS  */
+  if (cycles_active)
+    cycles_charge(CYC_LOAD);
+
+  if (undo_active)
+    undo_instruction(inst->addr, inst->bits);
+  if (trace_active)
+    trace_instruction(inst->addr, inst->bits);
 
 }
 
@@ -50,19 +181,21 @@ int logic_decode_instruction (instruction_t* inst) {
 
   /*  Extract the components from the instruction (instVal) */
 
-  inst->opcode              = (instVal >> 12) & 0xF;
+  inst->opcode              = get_opcode(instVal);
+  if (cycles_active)
+    cycles_decode(inst->opcode);
 
   
-  inst->DR                  = (instVal >> 9) & 0x7;
-  inst->SR1                 = (instVal >> 6) & 0x7;
-  inst->SR2                 = instVal & 0x7;
-  inst->bit5                = (instVal >> 5) & 0x1;
-  inst->bit11               = (instVal >> 11) & 0x1;
-  inst->trapvect8           = instVal & 0xff;
-  inst->imm5                = (instVal & 0x1f) << (32-5) >> (32-5);
-  inst->offset6             = (instVal & 0x3f) <<(32-6) >> (32-6);
-  inst->PCoffset9           = (instVal & 0x1ff) <<(32-9) >> (32-9);
-  inst->PCoffset11          = (instVal & 0x7ff) << (32-11) >> (32-11);
+  inst->DR                  = get_DR(instVal);
+  inst->SR1                 = get_SR1(instVal);
+  inst->SR2                 = get_SR2(instVal);
+  inst->bit5                = get_bit5(instVal);
+  inst->bit11               = get_bit11(instVal);
+  inst->trapvect8           = get_trapvect8(instVal);
+  inst->imm5                = get_imm5(instVal);
+  inst->offset6             = get_offset6(instVal);
+  inst->PCoffset9           = get_PCoffset9(instVal);
+  inst->PCoffset11          = get_PCoffset11(instVal);
    
   /* check for invalid instructions (i.e. fields which must be all 0's or 1's */
 
@@ -76,28 +209,28 @@ int logic_decode_instruction (instruction_t* inst) {
     case OP_ADD:
     case OP_AND: 
       if (inst->bit5 == 0x0)
-       if (((instVal>>3)&0x3) != 0x0)
+       if (GET_FIELD(instVal, 4, 3) != 0x0)
         valid = !OK;
       break;
 
     case OP_JSR_JSRR:
       if (inst->bit11 == 0x0)
-       if((instVal & 0x3F) != 0x0) 
+       if (GET_FIELD(instVal, 5, 0) != 0x0)
         valid = !OK;
       break;
 
     case OP_RTI:
-      if ((instVal & 0xfff) != 0x0 )
+      if (GET_FIELD(instVal, 11, 0) != 0x0)
         valid = !OK;
       break;
 
     case OP_NOT:
-      if ((instVal & 0x3f) != 0x3f )
+      if (GET_FIELD(instVal, 5, 0) != 0x3f)
         valid = !OK;
       break;
 
     case OP_JMP_RET:
-      if ((instVal & 0x3f) != 0x0 )
+      if (GET_FIELD(instVal, 5, 0) != 0x0)
         valid = !OK;
       break;
 
@@ -106,7 +239,7 @@ int logic_decode_instruction (instruction_t* inst) {
       break;
 
     case OP_TRAP:
-      if ((instVal >> 8) !=0x00f0)
+      if (GET_FIELD(instVal, 15, 8) != 0x00f0)
         valid = !OK;
       break;
  
@@ -132,8 +265,8 @@ static int execute_NOT (instruction_t* inst) {
 	LC3_WORD ALU = hardware_get_REG(inst->SR1);
 	ALU = ~ALU;
 	lc3_BUS = &ALU;
-	hardware_load_REG(inst->DR); 
-	hardware_set_CC(logic_NZP(ALU));         
+	load_REG(inst->DR); 
+	set_CC(logic_NZP(ALU));         
 	return 0;
 }
 
@@ -143,14 +276,14 @@ static int execute_ADD (instruction_t* inst) {
 	 LC3_WORD S2 = hardware_get_REG(inst->SR2);
 	 S1 = S1 + S2;
 	 lc3_BUS = &S1;
-	 hardware_load_REG(inst->DR);
-	 hardware_set_CC(logic_NZP(S1)); }
+	 load_REG(inst->DR);
+	 set_CC(logic_NZP(S1)); }
 	if (inst->bit5 == 0x1) {
 	 LC3_WORD val = hardware_get_REG(inst->SR1);
 	 val = val + inst->imm5;
 	 lc3_BUS = &val;
-	 hardware_load_REG(inst->DR);
-	 hardware_set_CC(logic_NZP(val)); }
+	 load_REG(inst->DR);
+	 set_CC(logic_NZP(val)); }
 	 
 	return 0;
 }
@@ -161,14 +294,14 @@ static int execute_AND (instruction_t* inst) {
 	 LC3_WORD S2 = hardware_get_REG(inst->SR2);
 	 S1 = (S1 & S2);
 	 lc3_BUS = &S1;
-	 hardware_load_REG(inst->DR);
-	 hardware_set_CC(logic_NZP(S1)); }
+	 load_REG(inst->DR);
+	 set_CC(logic_NZP(S1)); }
 	if (inst->bit5 == 0x1) {
 	 LC3_WORD val = hardware_get_REG(inst->SR1);
 	 val = val & inst->imm5;
 	 lc3_BUS = &val; 
-	 hardware_load_REG(inst->DR);
-	 hardware_set_CC(logic_NZP(val)); }
+	 load_REG(inst->DR);
+	 set_CC(logic_NZP(val)); }
 
 	return 0;
 }
@@ -176,30 +309,28 @@ static int execute_AND (instruction_t* inst) {
 static int execute_BR (instruction_t* inst) {
 	unsigned short NZP = hardware_get_CC();
 	LC3_WORD  newPC = hardware_get_PC() + inst->PCoffset9;
-	unsigned short check = inst->bits; 
-	check = ((check >> 9) & 0x7);
+	unsigned short check = get_DR(inst->bits); /* nzp */
 	if (NZP == 4) {
 	 if ((check == 4) || (check == 5) || (check == 6) || (check == 7)) {
-	  hardware_set_PC(newPC);
+	  set_PC(newPC);
 	  return 0; } }
 	if (NZP == 2) {
 	 if ((check == 3) || (check == 2) || (check == 6) || (check == 7)) {
-	  hardware_set_PC(newPC);
+	  set_PC(newPC);
 	  return 0; } }
 	if (NZP == 1) {
 	 if ((check == 1) || (check == 3) || (check == 5) || (check == 7)) {
-	  hardware_set_PC(newPC);
+	  set_PC(newPC);
 	  return 0; } } 
 	if (check == 0) {
-	 hardware_set_PC(newPC);
+	 set_PC(newPC);
 	 return 0; }
 	return 0; 
 }
 	 
 static int execute_JMP (instruction_t* inst) {
-	LC3_WORD check = inst->bits; 
-	check = (check >> 6) & 0x7;
-	hardware_set_PC(hardware_get_REG(check));
+	LC3_WORD check = get_SR1(inst->bits); /* BaseR */
+	set_PC(hardware_get_REG(check));
 	return 0;
 }
 
@@ -207,28 +338,28 @@ static int execute_LD (instruction_t* inst) {
 	LC3_WORD offset = inst->PCoffset9;
 	offset = offset + hardware_get_PC(); 
 	lc3_BUS = &offset;
-	hardware_load_MAR(); 
+	load_MAR(); 
 	
-	hardware_memory_enable(0);
+	memory_enable(0);
 	
-	hardware_gate_MDR();
-	hardware_load_REG(inst->DR); 
-	hardware_set_CC(logic_NZP(*lc3_BUS));
+	gate_MDR();
+	load_REG(inst->DR); 
+	set_CC(logic_NZP(*lc3_BUS));
 	return 0;
 }
 
 static int execute_TRAP (instruction_t* inst) {
 	LC3_WORD vect = inst->trapvect8;
 	lc3_BUS = &vect;
-	hardware_load_MAR();
+	load_MAR();
 	
-	hardware_memory_enable(0);
+	memory_enable(0);
 	LC3_WORD load = hardware_get_PC();
 	lc3_BUS = &load;
-	hardware_load_REG(7); 
+	load_REG(7); 
 
-	hardware_gate_MDR();
-	hardware_set_PC(*lc3_BUS);
+	gate_MDR();
+	set_PC(*lc3_BUS);
 	
 	return 0;
 }
@@ -237,13 +368,13 @@ static int execute_ST(instruction_t* inst) {
 	LC3_WORD currPC = hardware_get_PC();
 	currPC = currPC + inst->PCoffset9;
 	lc3_BUS = &currPC;
-	hardware_load_MAR();
+	load_MAR();
 
 	LC3_WORD regVal = hardware_get_REG(inst->DR);
 	lc3_BUS = &regVal;
-	hardware_load_MDR();
+	load_MDR();
 
-	hardware_memory_enable(1);
+	memory_enable(1);
 	return OK;
 }
 
@@ -251,19 +382,19 @@ static int execute_JSR_JSRR(instruction_t* inst) {
 	if (inst->bit11 == 1) {
 	 LC3_WORD currPC = hardware_get_PC();
 	 lc3_BUS = &currPC;
-	 hardware_load_REG(7);
+	 load_REG(7);
 
 	 currPC = currPC + (inst->PCoffset11);
-	 hardware_set_PC(currPC); 
+	 set_PC(currPC); 
 	
 	 return OK; }
 	if (inst->bit11 == 0) {
 	 LC3_WORD currPC = hardware_get_PC();
 	 lc3_BUS = &currPC;
-	 hardware_load_REG(7);
+	 load_REG(7);
 
-	 hardware_gate_REG(inst->SR1);
-	 hardware_set_PC(*lc3_BUS);
+	 gate_REG(inst->SR1);
+	 set_PC(*lc3_BUS);
 	 return OK; } 
 return 1;
 } 
@@ -272,13 +403,13 @@ static int execute_LDR(instruction_t* inst) {
 	LC3_WORD sr1 = hardware_get_REG(inst->SR1);
 	sr1 = sr1 + inst->offset6;
 	lc3_BUS = &sr1;
-	hardware_load_MAR();
+	load_MAR();
 
-	hardware_memory_enable(0);
+	memory_enable(0);
 
-	hardware_gate_MDR();
-	hardware_load_REG(inst->DR);
-	hardware_set_CC(logic_NZP(hardware_get_REG(inst->DR)));
+	gate_MDR();
+	load_REG(inst->DR);
+	set_CC(logic_NZP(hardware_get_REG(inst->DR)));
 
 	return OK;
 }
@@ -287,13 +418,13 @@ static int execute_STR(instruction_t* inst) {
 	LC3_WORD sr1 = hardware_get_REG(inst->SR1);
 	LC3_WORD both = sr1 + inst->offset6;
 	lc3_BUS = &both;
-	hardware_load_MAR();
+	load_MAR();
 	
 	LC3_WORD SR = hardware_get_REG(inst->DR);
 	lc3_BUS = &SR;
-	hardware_load_MDR();
+	load_MDR();
 
-	hardware_memory_enable(1);
+	memory_enable(1);
 	
 	return OK;
 }
@@ -301,34 +432,34 @@ static int execute_STR(instruction_t* inst) {
 static int execute_STI(instruction_t* inst) {
 	LC3_WORD val1 = hardware_get_PC() + (inst->PCoffset9);
 	lc3_BUS = &val1;
-	hardware_load_MAR();
+	load_MAR();
 
-	hardware_memory_enable(0);
+	memory_enable(0);
 
-	hardware_gate_MDR();
-	hardware_load_MAR();
+	gate_MDR();
+	load_MAR();
 
 	LC3_WORD sr1 = hardware_get_REG(inst->DR);
 	lc3_BUS = &sr1;
-	hardware_load_MDR();
+	load_MDR();
 
-	hardware_memory_enable(1);
+	memory_enable(1);
 	
 	return OK;
 } 
 
 static int execute_RTI(instruction_t* inst) {
-	hardware_gate_PSR();
+	gate_PSR();
 	LC3_WORD SP = *lc3_BUS;
 	if ((SP & 0x8000) == 0){
 	 LC3_WORD r6 = hardware_get_REG(6);
-	 hardware_set_PC(r6);
+	 set_PC(r6);
 	 r6 = r6 + 1;
 	 lc3_BUS = &r6;
-	 hardware_load_PSR();
+	 load_PSR();
 	 r6 = r6 + 1;
 	 lc3_BUS = &r6;
-	 hardware_load_REG(6);
+	 load_REG(6);
 	 return 0; }
 	return 1;
 }
@@ -336,28 +467,28 @@ static int execute_RTI(instruction_t* inst) {
 static int execute_LDI(instruction_t* inst) {
 	LC3_WORD val1 = hardware_get_PC() + inst->PCoffset9;
 	lc3_BUS = &val1;
-	hardware_load_MAR();
+	load_MAR();
 
-	hardware_memory_enable(0);
+	memory_enable(0);
 
-	hardware_gate_MDR();
-	hardware_load_MAR();
+	gate_MDR();
+	load_MAR();
 
-	hardware_memory_enable(0);
+	memory_enable(0);
 
-	hardware_gate_MDR();
+	gate_MDR();
 	val1 = *lc3_BUS;
-	hardware_load_REG(inst->DR);
-	hardware_set_CC(logic_NZP(val1));
+	load_REG(inst->DR);
+	set_CC(logic_NZP(val1));
 	return OK;
 } 
 
 static int execute_LEA(instruction_t* inst) {
 	LC3_WORD val1 = hardware_get_PC() + inst->PCoffset9;
 	lc3_BUS = &val1;
-	hardware_load_REG(inst->DR);
+	load_REG(inst->DR);
 
-	hardware_set_CC(logic_NZP(val1));
+	set_CC(logic_NZP(val1));
 
 	return OK;
 }
@@ -0,0 +1,157 @@
+/** @file memstats.c
+ *  @brief Implementation of the memstats.h interface
+ *  @details The counters are three flat arrays indexed by address, so
+ *  counting an access is a single increment.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "memstats.h"
+
+#define MS_FETCH  0
+#define MS_READ   1
+#define MS_WRITE  2
+#define MS_KINDS  3
+#define MS_SIZE   65536
+
+#define MS_TOP      10  /* busiest addresses printed          */
+#define MS_OVERLAP  8   /* overlapping addresses printed      */
+#define MS_PAGE     0x1000
+
+static unsigned long long ms_count[MS_KINDS][MS_SIZE];
+static LC3_WORD           ms_spMin, ms_spMax;
+static bool               ms_spSeen;
+
+void memstats_fetch (LC3_WORD addr) {
+  ms_count[MS_FETCH][addr]++;
+}
+
+void memstats_access (int rw, LC3_WORD addr) {
+  ms_count[rw ? MS_WRITE : MS_READ][addr]++;
+}
+
+void memstats_sp (LC3_WORD sp) {
+  if (! ms_spSeen) {
+    ms_spMin  = ms_spMax = sp;
+    ms_spSeen = true;
+  }
+  else if (sp < ms_spMin)
+    ms_spMin = sp;
+  else if (sp > ms_spMax)
+    ms_spMax = sp;
+}
+
+void memstats_reset (void) {
+  memset(ms_count, 0, sizeof(ms_count));
+  ms_spSeen = false;
+}
+
+static unsigned long long total_at (int addr) {
+  return ms_count[MS_FETCH][addr] + ms_count[MS_READ][addr]
+       + ms_count[MS_WRITE][addr];
+}
+
+static void print_addr (FILE* f, sym_table_t* symTab, int addr) {
+  char* label = symTab ? symbol_find_by_addr(symTab, addr) : NULL;
+  fprintf(f, "x%04X %-20s", addr, label ? label : "");
+}
+
+void memstats_report (FILE* f, sym_table_t* symTab) {
+  if (! MEM_STATS_ENABLED) {
+    fputs("memory statistics not compiled in (build with -DMEM_STATS)\n", f);
+    return;
+  }
+
+  unsigned long long sum[MS_KINDS] = { 0 };
+  unsigned long long page[MS_SIZE / MS_PAGE][MS_KINDS] = { { 0 } };
+  int                touched = 0, overlap = 0;
+
+  for (int addr = 0; addr < MS_SIZE; addr++) {
+    for (int k = 0; k < MS_KINDS; k++) {
+      sum[k] += ms_count[k][addr];
+      page[addr / MS_PAGE][k] += ms_count[k][addr];
+    }
+    if (total_at(addr))
+      touched++;
+    if (ms_count[MS_FETCH][addr] && ms_count[MS_WRITE][addr])
+      overlap++;
+  }
+
+  fprintf(f, "fetches: %llu  reads: %llu  writes: %llu  addresses: %d\n",
+          sum[MS_FETCH], sum[MS_READ], sum[MS_WRITE], touched);
+
+  if (touched) {
+    /* selection of the busiest addresses, one pass per entry */
+    int top[MS_TOP], numTop = 0;
+
+    fprintf(f, "\nbusiest addresses%11s %12s %12s %12s\n",
+            "", "fetch", "read", "write");
+    while ((numTop < MS_TOP) && (numTop < touched)) {
+      int best = -1;
+      for (int addr = 0; addr < MS_SIZE; addr++) {
+        bool used = false;
+        for (int i = 0; i < numTop; i++)
+          used |= (top[i] == addr);
+        if (! used && total_at(addr)
+            && ((best < 0) || (total_at(addr) > total_at(best))))
+          best = addr;
+      }
+      top[numTop++] = best;
+      fputs("  ", f);
+      print_addr(f, symTab, best);
+      fprintf(f, " %12llu %12llu %12llu\n", ms_count[MS_FETCH][best],
+              ms_count[MS_READ][best], ms_count[MS_WRITE][best]);
+    }
+
+    fprintf(f, "\npage%12s %12s %12s\n", "fetch", "read", "write");
+    for (int p = 0; p < MS_SIZE / MS_PAGE; p++) {
+      if (page[p][MS_FETCH] || page[p][MS_READ] || page[p][MS_WRITE])
+        fprintf(f, "x%04X %10llu %12llu %12llu\n", p * MS_PAGE,
+                page[p][MS_FETCH], page[p][MS_READ], page[p][MS_WRITE]);
+    }
+  }
+
+  if (ms_spSeen)
+    fprintf(f, "\nR6 range: x%04X - x%04X (%d words)\n", ms_spMin, ms_spMax,
+            ms_spMax - ms_spMin);
+  else
+    fputs("\nR6 never written\n", f);
+
+  if (overlap) {
+    fprintf(f, "\ncode/data overlap: %d addresses executed and written\n",
+            overlap);
+    for (int addr = 0, shown = 0; (addr < MS_SIZE) && (shown < MS_OVERLAP);
+         addr++) {
+      if (ms_count[MS_FETCH][addr] && ms_count[MS_WRITE][addr]) {
+        fputs("  ", f);
+        print_addr(f, symTab, addr);
+        fputs("\n", f);
+        shown++;
+      }
+    }
+  }
+}
+
+static void write_u32 (FILE* f, unsigned long long val) {
+  if (val > UINT32_MAX)
+    val = UINT32_MAX; /* saturate rather than wrap */
+  for (int i = 0; i < 4; i++)
+    fputc((val >> (8 * i)) & 0xFF, f);
+}
+
+int memstats_dump (const char* fileName) {
+  FILE* f = fopen(fileName, "wb");
+
+  if (f == NULL)
+    return 1;
+
+  fwrite("LC3HEAT", 1, 8, f); /* includes the '\0' */
+  write_u32(f, MS_KINDS);
+  write_u32(f, MS_SIZE);
+  for (int k = 0; k < MS_KINDS; k++)
+    for (int addr = 0; addr < MS_SIZE; addr++)
+      write_u32(f, ms_count[k][addr]);
+
+  return (fclose(f) != 0);
+}
@@ -0,0 +1,69 @@
+#ifndef __MEMSTATS_H__
+#define __MEMSTATS_H__
+
+/** @file memstats.h
+ *  @brief interface to the memory access counters (heatmap)
+ *  @details When the simulator is compiled with <code>-DMEM_STATS</code>,
+ *  the control logic (logic.c) counts every instruction fetch, data read and
+ *  data write for each of the 65536 addresses, and tracks the lowest and
+ *  highest value loaded into R6 (the stack pointer). Without the define,
+ *  the calls are compiled out in the same way as <code>debug()</code>
+ *  (see Debug.h), so the simulator pays nothing for them.
+ *  <p>
+ *  The counters are used to size stacks and to find places where code and
+ *  data overlap (an address that is both executed and written).
+ *  <p>
+ *  The heatmap file written by memstats_dump() is a 16 byte header followed
+ *  by three arrays of 65536 little endian 32 bit counts: fetches, reads and
+ *  writes, indexed by address. The header is the 8 bytes
+ *  <code>LC3HEAT\\0</code>, the number of arrays (3) and the number of
+ *  entries in each array (65536), both as little endian 32 bit values.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "lc3.h"
+
+#ifdef MEM_STATS
+#define MEM_STATS_ENABLED 1  // counters updated by logic.c
+#else
+/** Controls whether logic.c updates the counters. The value (0/1) depends
+ *  on whether the macro <tt>MEM_STATS</tt> is defined during the compile.
+ */
+#define MEM_STATS_ENABLED 0  // calls optimized out
+#endif
+
+/** Count an instruction fetch
+ *  @param addr - address of the instruction
+ */
+void memstats_fetch (LC3_WORD addr);
+
+/** Count a data read or write
+ *  @param rw - non zero for a write, zero for a read
+ *  @param addr - address accessed
+ */
+void memstats_access (int rw, LC3_WORD addr);
+
+/** Track a new value of the stack pointer (R6)
+ *  @param sp - value loaded into R6
+ */
+void memstats_sp (LC3_WORD sp);
+
+/** Clear all counters */
+void memstats_reset (void);
+
+/** Print a summary of the counters: totals, the busiest addresses, per page
+ *  activity, the stack pointer range and any code/data overlap.
+ *  @param f - where to print
+ *  @param symTab - used to print labels for addresses (may be NULL)
+ */
+void memstats_report (FILE* f, sym_table_t* symTab);
+
+/** Write the heatmap file (see above for the format)
+ *  @param fileName - name of the file to create
+ *  @return 0 on success, non-zero on failure
+ */
+int memstats_dump (const char* fileName);
+
+#endif /* __MEMSTATS_H__ */
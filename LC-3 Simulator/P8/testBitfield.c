@@ -0,0 +1,80 @@
+/** @file testBitfield.c
+ *  @brief test driver for the bulk field functions of bitfield.h
+ *  @details Extracts every field (15 &gt;= hi &gt;= lo &gt;= 0) of every 16 bit
+ *  word with <code>getFields()</code> and <code>getSFields()</code> and
+ *  compares each result with <code>getField()</code> as field.h defines it
+ *  and with the GET_FIELD/GET_SFIELD macros. getField() itself is the
+ *  student's field.c, so the test has its own bit by bit copy of it. The count leaves a few words over, so
+ *  both the SSE2 loop (when it is compiled in) and the scalar loop are
+ *  checked. Prints "testBitfield OK" and returns 0 if every check passes.
+ *  <pre><code>
+ *     make testBitfield && ./testBitfield
+ *  </code></pre>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bitfield.h"
+
+#define NUM_WORDS 65536
+#define COUNT     (NUM_WORDS - 5) /* not a multiple of 8 */
+
+/* getField() of field.h, one bit at a time */
+static int getField (int value, int hi, int lo, bool isSigned) {
+  int result = 0;
+
+  for (int bit = hi; bit >= lo; bit--)
+    result = (result << 1) | ((value >> bit) & 1);
+  if (isSigned && ((value >> hi) & 1))
+    result -= 1 << (hi - lo + 1);
+  return result;
+}
+
+int main (void) {
+  uint16_t* words   = malloc(NUM_WORDS * sizeof(uint16_t));
+  uint16_t* fields  = malloc(NUM_WORDS * sizeof(uint16_t));
+  int16_t*  sfields = malloc(NUM_WORDS * sizeof(int16_t));
+  long      errors  = 0;
+
+  if (!words || !fields || !sfields) {
+    printf("testBitfield: cannot allocate %d words\n", NUM_WORDS);
+    return 1;
+  }
+
+  for (int w = 0; w < NUM_WORDS; w++)
+    words[w] = (uint16_t) w;
+
+  for (int hi = 0; hi < 16; hi++) {
+    for (int lo = 0; lo <= hi; lo++) {
+      /* start one word in, so the vector loads are not aligned */
+      getFields(words + 1, COUNT, hi, lo, fields);
+      getSFields(words + 1, COUNT, hi, lo, sfields);
+
+      for (int i = 0; i < COUNT; i++) {
+        int value     = words[i + 1];
+        int expected  = getField(value, hi, lo, false);
+        int sexpected = getField(value, hi, lo, true);
+
+        if (fields[i] != expected || GET_FIELD(value, hi, lo) != expected
+            || sfields[i] != sexpected
+            || GET_SFIELD(value, hi, lo) != sexpected) {
+          if (errors++ < 10)
+            printf("FAIL x%04X [%d:%d]: getFields %d getSFields %d "
+                   "expected %d and %d\n", value, hi, lo, fields[i],
+                   sfields[i], expected, sexpected);
+        }
+      }
+    }
+  }
+
+  if (errors)
+    printf("testBitfield: %ld errors\n", errors);
+  else
+    printf("testBitfield OK\n");
+
+  free(words);
+  free(fields);
+  free(sfields);
+  return errors != 0;
+}
@@ -0,0 +1,117 @@
+/** @file testCache.c
+ *  @brief test driver for the per label rates of the cache model
+ *  @details Runs a fixed pattern of accesses through the data cache and
+ *  checks which labels the report charges them to: a label gets the
+ *  accesses up to the next label (at most 256 words), and addresses far
+ *  from any label, or in device space, are charged to none. Prints
+ *  "testCache OK" and returns 0 if every check passes.
+ *  <pre><code>
+ *     make testCache && ./testCache
+ *  </code></pre>
+ */
+
+#define _POSIX_C_SOURCE 200809L /* open_memstream() */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache.h"
+#include "symbol.h"
+
+static int failures = 0;
+
+/* Find the report line for name and return its access and miss counts, or
+   return 0 if the label is not in the report. */
+static int find_label (const char* report, const char* name,
+                       unsigned long long* accesses,
+                       unsigned long long* misses) {
+  char        label[64];
+  const char* line = report;
+
+  while (line && *line) {
+    if (sscanf(line, " %63s %llu %llu", label, accesses, misses) == 3
+        && strcmp(label, name) == 0)
+      return 1;
+    line = strchr(line, '\n');
+    if (line)
+      line++;
+  }
+  return 0;
+}
+
+static void expect (const char* report, const char* name, int present,
+                    unsigned long long accesses) {
+  unsigned long long gotAccesses = 0, gotMisses = 0;
+  int found = find_label(report, name, &gotAccesses, &gotMisses);
+
+  if (found != present || (present && gotAccesses != accesses)) {
+    failures++;
+    if (present)
+      printf("FAIL %s: expected %llu accesses, got %s%llu\n", name, accesses,
+             found ? "" : "no line, ", gotAccesses);
+    else
+      printf("FAIL %s: expected no line, got %llu accesses\n", name,
+             gotAccesses);
+  }
+}
+
+int main (void) {
+  sym_table_t* symTab = symbol_init(100);
+  char*        report = NULL;
+  size_t       size   = 0;
+
+  if (symTab == NULL || cache_enable(true) != 0) {
+    printf("testCache: cannot allocate the symbol table or caches\n");
+    return 1;
+  }
+
+  /* the last labels of lc3os, and a user program at x3000 */
+  symbol_add(symTab, "OS_HALT_MSG",  0x02D0);
+  symbol_add(symTab, "OS_START_MSG", 0x02E6);
+  symbol_add(symTab, "MAIN",         0x3000);
+  symbol_add(symTab, "DATA",         0x3010);
+  symbol_add(symTab, "LAST",         0xFDF8);
+
+  for (int pass = 0; pass < 3; pass++) {
+    for (LC3_WORD addr = 0x3000; addr < 0x3008; addr++)
+      cache_data(addr);                          /* 24 for MAIN          */
+    cache_data(0x3010);                          /*  3 for DATA          */
+    cache_data(0x3200);                          /* beyond DATA's span   */
+    cache_data(0x4000);                          /* no label near        */
+    cache_data(0xFDFF);                          /*  3 for LAST          */
+    cache_data(0xFE04);                          /* device, no label     */
+  }
+  cache_data(0x02E6);                            /*  1 for OS_START_MSG  */
+
+  FILE* f = open_memstream(&report, &size);
+  if (f == NULL) {
+    printf("testCache: cannot open the report\n");
+    return 1;
+  }
+  cache_report(f, symTab);
+  fclose(f);
+
+  /* the D-cache part of the report */
+  char* dcache = strstr(report, "D-cache");
+  if (dcache == NULL) {
+    printf("FAIL: no D-cache report\n%s", report);
+    return 1;
+  }
+
+  expect(dcache, "MAIN",         1, 24);
+  expect(dcache, "DATA",         1, 3);
+  expect(dcache, "LAST",         1, 3);
+  expect(dcache, "OS_START_MSG", 1, 1);
+  expect(dcache, "OS_HALT_MSG",  0, 0);
+  expect(dcache, "total",        1, 3 * 13 + 1);
+
+  if (failures)
+    printf("%s", dcache);
+  else
+    printf("testCache OK\n");
+
+  free(report);
+  symbol_term(symTab);
+  return failures != 0;
+}
@@ -0,0 +1,485 @@
+/** @file trace.c
+ *  @brief Implementation of the trace.h interface
+ *  @details Records are appended to one of a small ring of fixed size blocks.
+ *  When a block fills, it is handed to a writer thread and the simulator
+ *  continues filling the next block. The simulator only waits if the writer
+ *  falls a full ring behind. The writer encodes each block (see trace.h for
+ *  the format) and writes it with a single call to fwrite(). A failed write
+ *  is remembered and reported by trace_stop(); the writer keeps emptying
+ *  blocks so the simulator never waits on a trace that cannot be written.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Debug.h"
+#include "trace.h"
+
+/** number of records in one block                                  */
+#define TRACE_BLOCK_RECS 32768
+
+/** number of blocks in the ring shared with the writer thread      */
+#define TRACE_NUM_BLOCKS 8
+
+/** worst case size of one encoded record                           */
+#define TRACE_MAX_REC_LEN 16
+
+/** flag bit in the file: PC is not the expected value              */
+#define TRACE_PC 0x10
+
+/** size of the block header in the file                            */
+#define TRACE_HDR_LEN 12
+
+/** size of the writer's buffer for one encoded block               */
+#define TRACE_OUT_LEN (TRACE_HDR_LEN + TRACE_BLOCK_RECS * TRACE_MAX_REC_LEN)
+
+/** identifies a trace file                                         */
+static const char trace_magic[8] = { 'L', 'C', '3', 'T', 'R', 'A', 'C', 'E' };
+
+/** A block of records shared between the simulator and the writer */
+typedef struct trace_block {
+  trace_rec_t recs[TRACE_BLOCK_RECS]; /**< the records                    */
+  int         count;                  /**< records used in this block     */
+  int         insts;                  /**< instructions (non TRACE_CONT)  */
+  bool        full;                   /**< owned by the writer thread     */
+} trace_block_t;
+
+/** Reader state */
+struct trace_reader {
+  FILE*              f;           /**< the trace file                     */
+  unsigned char*     buf;         /**< payload of the current block       */
+  int                bufLen;      /**< allocated size of buf              */
+  unsigned char*     pos;         /**< next byte to decode                */
+  int                recsLeft;    /**< records left in current block      */
+  LC3_WORD           prevPC;      /**< PC of previous record              */
+  LC3_WORD           prevIR;      /**< IR of previous record              */
+  LC3_WORD           prevMem;     /**< address of previous memory write   */
+  unsigned long long base;        /**< instruction number of next block   */
+  unsigned long long index;       /**< instruction number of last record  */
+};
+
+bool trace_active = false;
+
+static FILE*              trace_file;
+static trace_block_t*     trace_blocks;
+static unsigned char*     trace_out;    /* encoded block, writer thread    */
+static int                trace_head;   /* block being filled by simulator */
+static int                trace_tail;   /* next block for writer           */
+static trace_rec_t*       trace_cur;    /* record of current instruction   */
+static unsigned long long trace_insts;  /* instructions recorded           */
+static bool               trace_stopping;
+static bool               trace_failed; /* a write to the file failed      */
+static pthread_t          trace_thread;
+static pthread_mutex_t    trace_lock     = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t     trace_filled   = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t     trace_emptied  = PTHREAD_COND_INITIALIZER;
+
+static void put32 (unsigned char* p, unsigned int v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+static unsigned int get32 (const unsigned char* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+static unsigned char* put_varint (unsigned char* p, unsigned int v) {
+  while (v >= 0x80) {
+    *p++ = (v & 0x7F) | 0x80;
+    v >>= 7;
+  }
+  *p++ = v;
+  return p;
+}
+
+static const unsigned char* get_varint (const unsigned char* p,
+                                        unsigned int* v) {
+  unsigned int val   = 0;
+  int          shift = 0;
+
+  while (*p & 0x80) {
+    val |= (*p++ & 0x7F) << shift;
+    shift += 7;
+  }
+  *v = val | (*p++ << shift);
+  return p;
+}
+
+/** map a 16 bit signed delta to small unsigned values (zig-zag) */
+static unsigned int zigzag (LC3_WORD from, LC3_WORD to) {
+  short delta = (short) (LC3_WORD) (to - from);
+  return (unsigned int) ((delta << 1) ^ (delta >> 15)) & 0x1FFFF;
+}
+
+static LC3_WORD unzigzag (LC3_WORD from, unsigned int z) {
+  int delta = (z >> 1) ^ -(int) (z & 1);
+  return (LC3_WORD) (from + delta);
+}
+
+/** Encode one block into out, return the payload length */
+static int encode_block (const trace_block_t* blk, unsigned char* out) {
+  unsigned char* p       = out + TRACE_HDR_LEN;
+  LC3_WORD       prevPC  = 0xFFFF;
+  LC3_WORD       prevMem = 0;
+
+  for (int i = 0; i < blk->count; i++) {
+    const trace_rec_t* r      = &blk->recs[i];
+    bool               cont   = (r->flags & TRACE_CONT) != 0;
+    LC3_WORD           expect = cont ? prevPC : (LC3_WORD) (prevPC + 1);
+    unsigned char      flags  = r->flags | (r->reg << 5);
+
+    if (r->pc != expect)
+      flags |= TRACE_PC;
+
+    *p++ = flags;
+    if (flags & TRACE_PC)
+      p = put_varint(p, zigzag(expect, r->pc));
+    if ((! cont) || (i == 0)) { /* IR of a continuation is the previous IR */
+      *p++ = r->ir;
+      *p++ = r->ir >> 8;
+    }
+    if (r->flags & TRACE_REG)
+      p = put_varint(p, r->regVal);
+    if (r->flags & TRACE_MEM) {
+      p = put_varint(p, zigzag(prevMem, r->memAddr));
+      p = put_varint(p, r->memVal);
+      prevMem = r->memAddr;
+    }
+    prevPC = r->pc;
+  }
+
+  int len = p - out - TRACE_HDR_LEN;
+  put32(out, len);
+  put32(out + 4, blk->count);
+  put32(out + 8, blk->insts);
+  return len;
+}
+
+static void* trace_writer (void* arg) {
+  pthread_mutex_lock(&trace_lock);
+  while (1) {
+    trace_block_t* blk = &trace_blocks[trace_tail];
+
+    while (! blk->full && ! trace_stopping)
+      pthread_cond_wait(&trace_filled, &trace_lock);
+
+    if (! blk->full)
+      break; /* stopping and nothing left to write */
+
+    bool failed = trace_failed;
+    pthread_mutex_unlock(&trace_lock);
+    if (! failed) {
+      size_t len = TRACE_HDR_LEN + encode_block(blk, trace_out);
+      failed = (fwrite(trace_out, 1, len, trace_file) != len);
+    }
+    pthread_mutex_lock(&trace_lock);
+
+    trace_failed = failed;
+    blk->full    = false;
+    trace_tail   = (trace_tail + 1) % TRACE_NUM_BLOCKS;
+    pthread_cond_signal(&trace_emptied);
+  }
+  pthread_mutex_unlock(&trace_lock);
+
+  return NULL;
+}
+
+/** Hand the current block to the writer and wait for the next to be free */
+static void publish_block (void) {
+  pthread_mutex_lock(&trace_lock);
+  trace_blocks[trace_head].full = true;
+  pthread_cond_signal(&trace_filled);
+
+  trace_head = (trace_head + 1) % TRACE_NUM_BLOCKS;
+  while (trace_blocks[trace_head].full)
+    pthread_cond_wait(&trace_emptied, &trace_lock);
+  pthread_mutex_unlock(&trace_lock);
+
+  trace_blocks[trace_head].count = 0;
+  trace_blocks[trace_head].insts = 0;
+}
+
+static trace_rec_t* new_record (void) {
+  trace_block_t* blk = &trace_blocks[trace_head];
+
+  if (blk->count == TRACE_BLOCK_RECS) {
+    publish_block();
+    blk = &trace_blocks[trace_head];
+  }
+
+  return &blk->recs[blk->count++];
+}
+
+/** Start a continuation record when an instruction writes a second time */
+static trace_rec_t* cont_record (void) {
+  LC3_WORD pc = trace_cur->pc;
+  LC3_WORD ir = trace_cur->ir;
+
+  trace_cur        = new_record();
+  trace_cur->pc    = pc;
+  trace_cur->ir    = ir;
+  trace_cur->flags = TRACE_CONT;
+  trace_cur->reg   = 0;
+  return trace_cur;
+}
+
+/** Flush the trace however the simulator exits */
+static void trace_stop_at_exit (void) {
+  trace_stop();
+}
+
+int trace_start (const char* fileName) {
+  static bool registered = false;
+
+  trace_stop();
+
+  if (! registered)
+    registered = (atexit(trace_stop_at_exit) == 0);
+
+  /* the buffers are kept for the next trace */
+  if (trace_blocks == NULL)
+    trace_blocks = malloc(TRACE_NUM_BLOCKS * sizeof(trace_block_t));
+  if (trace_out == NULL)
+    trace_out = malloc(TRACE_OUT_LEN);
+  if ((trace_blocks == NULL) || (trace_out == NULL))
+    return -1;
+
+  if ((trace_file = fopen(fileName, "wb")) == NULL)
+    return -1;
+
+  for (int i = 0; i < TRACE_NUM_BLOCKS; i++) {
+    trace_blocks[i].count = 0;
+    trace_blocks[i].insts = 0;
+    trace_blocks[i].full  = false;
+  }
+
+  trace_failed   = (fwrite(trace_magic, 1, sizeof(trace_magic), trace_file)
+                    != sizeof(trace_magic));
+  trace_head     = 0;
+  trace_tail     = 0;
+  trace_cur      = NULL;
+  trace_insts    = 0;
+  trace_stopping = false;
+
+  if (pthread_create(&trace_thread, NULL, trace_writer, NULL) != 0) {
+    fclose(trace_file);
+    trace_file = NULL;
+    return -1;
+  }
+
+  trace_active = true;
+  debug("tracing to %s", fileName);
+  return 0;
+}
+
+int trace_stop (void) {
+  if (! trace_active)
+    return 0;
+
+  trace_active = false;
+
+  pthread_mutex_lock(&trace_lock);
+  if (trace_blocks[trace_head].count > 0)
+    trace_blocks[trace_head].full = true;
+  trace_stopping = true;
+  pthread_cond_signal(&trace_filled);
+  pthread_mutex_unlock(&trace_lock);
+
+  pthread_join(trace_thread, NULL);
+  if (fclose(trace_file) != 0)
+    trace_failed = true;
+  trace_file = NULL;
+  debug("trace stopped after %llu instructions%s", trace_insts,
+        trace_failed ? ", some were not written" : "");
+  return trace_failed ? -1 : 0;
+}
+
+unsigned long long trace_count (void) {
+  return trace_insts;
+}
+
+void trace_instruction (LC3_WORD pc, LC3_WORD ir) {
+  trace_cur        = new_record();
+  trace_cur->pc    = pc;
+  trace_cur->ir    = ir;
+  trace_cur->flags = 0;
+  trace_cur->reg   = 0;
+  trace_blocks[trace_head].insts++;
+  trace_insts++;
+}
+
+void trace_reg_write (int regNum, LC3_WORD value) {
+  if (trace_cur == NULL)
+    return; /* trace started in the middle of an instruction */
+
+  trace_rec_t* r = trace_cur;
+
+  if (r->flags & (TRACE_REG | TRACE_MEM))
+    r = cont_record();
+
+  r->flags  |= TRACE_REG;
+  r->reg     = regNum;
+  r->regVal  = value;
+}
+
+void trace_mem_write (LC3_WORD addr, LC3_WORD value) {
+  if (trace_cur == NULL)
+    return;
+
+  trace_rec_t* r = trace_cur;
+
+  if (r->flags & TRACE_MEM)
+    r = cont_record();
+
+  r->flags   |= TRACE_MEM;
+  r->memAddr  = addr;
+  r->memVal   = value;
+}
+
+trace_reader_t* trace_open (const char* fileName) {
+  char  magic[sizeof(trace_magic)];
+  FILE* f = fopen(fileName, "rb");
+
+  if (f == NULL)
+    return NULL;
+
+  if ((fread(magic, 1, sizeof(magic), f) != sizeof(magic))
+      || (memcmp(magic, trace_magic, sizeof(magic)) != 0)) {
+    fclose(f);
+    return NULL;
+  }
+
+  trace_reader_t* reader = calloc(1, sizeof(trace_reader_t));
+  if (reader == NULL) {
+    fclose(f);
+    return NULL;
+  }
+  reader->f = f;
+  return reader;
+}
+
+/** Read the next block header, return false at end of file */
+static bool read_header (trace_reader_t* reader, int* len, int* recs,
+                         int* insts) {
+  unsigned char hdr[TRACE_HDR_LEN];
+
+  if (fread(hdr, 1, sizeof(hdr), reader->f) != sizeof(hdr))
+    return false;
+
+  *len   = get32(hdr);
+  *recs  = get32(hdr + 4);
+  *insts = get32(hdr + 8);
+  return true;
+}
+
+static bool load_block (trace_reader_t* reader) {
+  int len, recs, insts;
+
+  if (! read_header(reader, &len, &recs, &insts))
+    return false;
+
+  if (len > reader->bufLen) {
+    free(reader->buf);
+    reader->bufLen = 0;
+    if ((reader->buf = malloc(len)) == NULL)
+      return false;
+    reader->bufLen = len;
+  }
+
+  if (fread(reader->buf, 1, len, reader->f) != (size_t) len)
+    return false;
+
+  reader->pos      = reader->buf;
+  reader->recsLeft = recs;
+  reader->prevPC   = 0xFFFF;
+  reader->prevMem  = 0;
+  reader->index    = reader->base - 1; /* incremented by first record */
+  reader->base    += insts;
+  return true;
+}
+
+bool trace_next (trace_reader_t* reader, trace_rec_t* rec,
+                 unsigned long long* index) {
+  while (reader->recsLeft == 0) {
+    if (! load_block(reader))
+      return false;
+  }
+
+  const unsigned char* p      = reader->pos;
+  bool                 first  = (p == reader->buf);
+  unsigned char        flags  = *p++;
+  bool                 cont   = (flags & TRACE_CONT) != 0;
+  LC3_WORD             expect = cont ? reader->prevPC
+                                     : (LC3_WORD) (reader->prevPC + 1);
+  unsigned int         v;
+
+  rec->flags = flags & (TRACE_REG | TRACE_MEM | TRACE_CONT);
+  rec->reg   = flags >> 5;
+  rec->pc    = expect;
+
+  if (flags & TRACE_PC) {
+    p       = get_varint(p, &v);
+    rec->pc = unzigzag(expect, v);
+  }
+
+  if ((! cont) || first) {
+    reader->prevIR = p[0] | (p[1] << 8);
+    p += 2;
+  }
+
+  if (! cont)
+    reader->index++;
+
+  rec->ir        = reader->prevIR;
+  reader->prevPC = rec->pc;
+
+  if (flags & TRACE_REG) {
+    p = get_varint(p, &v);
+    rec->regVal = v;
+  }
+
+  if (flags & TRACE_MEM) {
+    p = get_varint(p, &v);
+    rec->memAddr = unzigzag(reader->prevMem, v);
+    p = get_varint(p, &v);
+    rec->memVal = v;
+    reader->prevMem = rec->memAddr;
+  }
+
+  reader->pos = (unsigned char*) p;
+  reader->recsLeft--;
+  *index = reader->index;
+  return true;
+}
+
+void trace_seek (trace_reader_t* reader, unsigned long long index) {
+  int len, recs, insts;
+
+  reader->recsLeft = 0; /* discard rest of current block */
+
+  while (1) {
+    long where = ftell(reader->f);
+
+    if (! read_header(reader, &len, &recs, &insts))
+      return;
+
+    if (reader->base + insts > index) {
+      fseek(reader->f, where, SEEK_SET);
+      return;
+    }
+
+    reader->base += insts;
+    fseek(reader->f, len, SEEK_CUR);
+  }
+}
+
+void trace_close (trace_reader_t* reader) {
+  if (reader) {
+    fclose(reader->f);
+    free(reader->buf);
+    free(reader);
+  }
+}
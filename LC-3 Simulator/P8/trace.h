@@ -0,0 +1,123 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+/** @file trace.h
+ *  @brief interface to the execution trace recorder and reader
+ *  @details The recorder captures every instruction the simulator executes:
+ *  the address of the instruction (PC), the instruction itself (IR), and any
+ *  register or memory write it performs. The control logic (logic.c) reports
+ *  these events as they happen. The events are appended to an in memory
+ *  buffer, so the cost to the simulator is a few stores per instruction.
+ *  A background thread encodes full buffers and writes them to the trace file.
+ *  <p>
+ *  The trace file starts with an 8 byte magic value (<code>LC3TRACE</code>)
+ *  and is followed by a sequence of self contained blocks. Each block has a
+ *  12 byte header (payload length, record count, instruction count, all
+ *  little endian 32 bit values) followed by the encoded records. Within a
+ *  block, the PC is delta encoded against the next sequential address,
+ *  memory addresses are delta encoded against the previous memory write,
+ *  and values are written as variable length integers (7 bits per byte).
+ *  Because deltas restart in each block, a reader can skip a block using
+ *  only its header.
+ *  <p>
+ *  The reader half of this interface is used by the offline tool
+ *  <code>lc3trace</code>.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "lc3.h"
+
+/** record contains a register write (register number in TRACE_REG_NUM)  */
+#define TRACE_REG      0x01
+
+/** record contains a memory write                                       */
+#define TRACE_MEM      0x02
+
+/** record continues the previous instruction (a second write)          */
+#define TRACE_CONT     0x04
+
+/** One executed instruction (or the continuation of one) */
+typedef struct trace_rec {
+  LC3_WORD      pc;      /**< address of the instruction                  */
+  LC3_WORD      ir;      /**< the instruction                             */
+  LC3_WORD      regVal;  /**< value written to register (if TRACE_REG)    */
+  LC3_WORD      memAddr; /**< address written (if TRACE_MEM)              */
+  LC3_WORD      memVal;  /**< value written to memory (if TRACE_MEM)      */
+  unsigned char flags;   /**< TRACE_REG | TRACE_MEM | TRACE_CONT          */
+  unsigned char reg;     /**< register number 0..7 (if TRACE_REG)         */
+} trace_rec_t;
+
+/** True while a trace is being recorded. Tested by the control logic before
+ *  reporting an event, so recording costs nothing when it is off.
+ */
+extern bool trace_active;
+
+/** Begin recording to a file. An existing trace is stopped first.
+ *  @param fileName - name of the trace file (created/truncated)
+ *  @return 0 on success, non-zero if the file could not be opened or the
+ *  buffers could not be allocated
+ */
+int trace_start (const char* fileName);
+
+/** Stop recording, flush all buffered records and close the trace file.
+ *  Does nothing if no trace is active.
+ *  @return 0 on success, non-zero if any part of the trace could not be
+ *  written (the file is incomplete)
+ */
+int trace_stop (void);
+
+/** Return the number of instructions recorded by the active trace */
+unsigned long long trace_count (void);
+
+/** Report that an instruction was fetched. Starts a new record.
+ *  @param pc - address of the instruction
+ *  @param ir - the instruction
+ */
+void trace_instruction (LC3_WORD pc, LC3_WORD ir);
+
+/** Report a register write by the current instruction.
+ *  @param regNum - register written (0-7)
+ *  @param value - the new value
+ */
+void trace_reg_write (int regNum, LC3_WORD value);
+
+/** Report a memory write by the current instruction.
+ *  @param addr - address written
+ *  @param value - the new value
+ */
+void trace_mem_write (LC3_WORD addr, LC3_WORD value);
+
+/** Opaque state for reading a trace file */
+typedef struct trace_reader trace_reader_t;
+
+/** Open a trace file for reading
+ *  @param fileName - name of the trace file
+ *  @return the reader, or NULL if the file is missing or not a trace
+ */
+trace_reader_t* trace_open (const char* fileName);
+
+/** Get the next record from the trace
+ *  @param reader - the reader returned by trace_open()
+ *  @param rec - where the record is stored
+ *  @param index - where the (0 based) instruction number is stored
+ *  @return true if a record was read, false at end of trace (or on error)
+ */
+bool trace_next (trace_reader_t* reader, trace_rec_t* rec,
+                 unsigned long long* index);
+
+/** Skip whole blocks until the block containing instruction index is
+ *  reached. The next call to trace_next() returns the first record of that
+ *  block.
+ *  @param reader - the reader returned by trace_open()
+ *  @param index - the instruction to seek towards
+ */
+void trace_seek (trace_reader_t* reader, unsigned long long index);
+
+/** Close the trace and free the reader
+ *  @param reader - the reader returned by trace_open()
+ */
+void trace_close (trace_reader_t* reader);
+
+#endif /* __TRACE_H__ */
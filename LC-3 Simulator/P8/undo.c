@@ -0,0 +1,140 @@
+/** @file undo.c
+ *  @brief Implementation of the undo.h interface
+ *  @details The log is a ring of undo_rec_t. <code>undo_head</code> is the
+ *  record of the instruction currently executing (the most recent one), and
+ *  <code>undo_count</code> is the number of valid records ending there.
+ */
+
+#include <stdlib.h>
+
+#include "Debug.h"
+#include "hardware.h"
+#include "undo.h"
+
+/** lowest address of the memory mapped device registers */
+#define UNDO_IO_BASE 0xFE00
+
+extern LC3_WORD get_PSR (void);
+extern void set_PSR (int val);
+
+bool undo_active = false;
+
+static undo_rec_t* undo_log;     /* the ring                        */
+static size_t      undo_size;    /* number of records in the ring   */
+static size_t      undo_head;    /* index of most recent record     */
+static size_t      undo_count;   /* valid records ending at head    */
+static undo_rec_t* undo_cur;     /* record of current instruction   */
+
+size_t undo_enable (size_t maxBytes) {
+  undo_disable();
+
+  undo_size = maxBytes / sizeof(undo_rec_t);
+  if ((undo_size == 0)
+      || ((undo_log = malloc(undo_size * sizeof(undo_rec_t))) == NULL)) {
+    undo_size = 0;
+    return 0;
+  }
+
+  undo_clear();
+  undo_active = true;
+  debug("undo log holds %zu instructions", undo_size);
+  return undo_size;
+}
+
+void undo_disable (void) {
+  undo_active = false;
+  free(undo_log);
+  undo_log  = NULL;
+  undo_size = 0;
+  undo_clear();
+}
+
+void undo_clear (void) {
+  undo_head  = undo_size - 1; /* first record goes to index 0 */
+  undo_count = 0;
+  undo_cur   = NULL;
+}
+
+size_t undo_depth (void) {
+  return undo_count;
+}
+
+void undo_instruction (LC3_WORD pc, LC3_WORD ir) {
+  undo_head = (undo_head + 1 == undo_size) ? 0 : undo_head + 1;
+  if (undo_count < undo_size)
+    undo_count++;
+
+  undo_cur          = &undo_log[undo_head];
+  undo_cur->pc      = pc;
+  undo_cur->ir      = ir;
+  undo_cur->psr     = get_PSR();
+  undo_cur->numRegs = 0;
+  undo_cur->hasMem  = 0;
+}
+
+void undo_reg_write (int regNum) {
+  if ((undo_cur == NULL) || (undo_cur->numRegs == 2))
+    return;
+
+  int n = undo_cur->numRegs++;
+  undo_cur->regNum[n] = regNum;
+  undo_cur->regOld[n] = hardware_get_REG(regNum);
+}
+
+void undo_mem_write (LC3_WORD addr, LC3_WORD value) {
+  if ((undo_cur == NULL) || undo_cur->hasMem || (addr >= UNDO_IO_BASE))
+    return;
+
+  /* read the old value, then put the MDR back the way it was */
+  LC3_WORD* bus = lc3_BUS;
+  LC3_WORD  mar = addr;
+  LC3_WORD  mdr = value;
+
+  lc3_BUS = &mar;
+  hardware_load_MAR();
+  hardware_memory_enable(0);
+  hardware_gate_MDR();
+  undo_cur->memOld  = *lc3_BUS;
+  undo_cur->memAddr = addr;
+  undo_cur->hasMem  = 1;
+
+  lc3_BUS = &mdr;
+  hardware_load_MDR();
+  lc3_BUS = bus;
+}
+
+bool undo_step (LC3_WORD* ir) {
+  if (undo_count == 0)
+    return false;
+
+  undo_rec_t* rec = &undo_log[undo_head];
+  LC3_WORD*   bus = lc3_BUS;
+  LC3_WORD    val;
+
+  if (rec->hasMem) {
+    val = rec->memAddr;
+    lc3_BUS = &val;
+    hardware_load_MAR();
+    val = rec->memOld;
+    hardware_load_MDR();
+    hardware_memory_enable(1);
+  }
+
+  for (int i = rec->numRegs - 1; i >= 0; i--) {
+    val = rec->regOld[i];
+    lc3_BUS = &val;
+    hardware_load_REG(rec->regNum[i]);
+  }
+
+  set_PSR(rec->psr);
+  hardware_set_PC(rec->pc);
+  lc3_BUS = bus;
+
+  if (ir)
+    *ir = rec->ir;
+
+  undo_head = (undo_head == 0) ? undo_size - 1 : undo_head - 1;
+  undo_count--;
+  undo_cur = NULL;
+  return true;
+}
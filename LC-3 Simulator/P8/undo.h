@@ -0,0 +1,88 @@
+#ifndef __UNDO_H__
+#define __UNDO_H__
+
+/** @file undo.h
+ *  @brief interface to the undo log used for reverse execution
+ *  @details While the log is enabled, the control logic (logic.c) reports
+ *  the start of each instruction and, <b>before</b> each register or memory
+ *  write, the location about to be written. The log saves the old values
+ *  (and the PC and PSR at the start of the instruction) in one fixed size
+ *  record per instruction. Undoing an instruction writes the old values back,
+ *  so stepping backwards costs the same as stepping forwards.
+ *  <p>
+ *  The records are kept in a ring buffer whose size is set when the log is
+ *  enabled. When it is full, the oldest instructions are forgotten. Each
+ *  record is <code>sizeof(undo_rec_t)</code> bytes, so 10 million
+ *  instructions need a little under 200 MB.
+ *  <p>
+ *  Writes to the memory mapped device registers (xFE00 and above) are not
+ *  undone. Neither is I/O performed by the program.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "lc3.h"
+
+/** One executed instruction */
+typedef struct undo_rec {
+  LC3_WORD      pc;        /**< address of the instruction                */
+  LC3_WORD      ir;        /**< the instruction                           */
+  LC3_WORD      psr;       /**< PSR (and condition codes) before          */
+  LC3_WORD      regOld[2]; /**< old values of registers written           */
+  LC3_WORD      memAddr;   /**< address written (if hasMem)               */
+  LC3_WORD      memOld;    /**< old value at memAddr (if hasMem)          */
+  unsigned char regNum[2]; /**< registers written                         */
+  unsigned char numRegs;   /**< number of registers written (0..2)        */
+  unsigned char hasMem;    /**< non-zero if memory was written            */
+} undo_rec_t;
+
+/** True while the log is recording. Tested by the control logic before
+ *  reporting an event, so the log costs nothing when it is off.
+ */
+extern bool undo_active;
+
+/** Enable the log, discarding any previous contents.
+ *  @param maxBytes - memory to use for the log
+ *  @return the number of instructions that can be undone, 0 on failure
+ */
+size_t undo_enable (size_t maxBytes);
+
+/** Disable the log and release its memory */
+void undo_disable (void);
+
+/** Forget all recorded instructions. Called when the machine state is
+ *  changed outside of normal execution (reset, loading a file, setting a
+ *  register or memory location from the debugger).
+ */
+void undo_clear (void);
+
+/** Return the number of instructions that can currently be undone */
+size_t undo_depth (void);
+
+/** Report that an instruction was fetched. Starts a new record.
+ *  @param pc - address of the instruction
+ *  @param ir - the instruction
+ */
+void undo_instruction (LC3_WORD pc, LC3_WORD ir);
+
+/** Report that a register is about to be written
+ *  @param regNum - register to be written (0-7)
+ */
+void undo_reg_write (int regNum);
+
+/** Report that memory is about to be written. The MAR must already contain
+ *  addr, and the MDR the value to be written.
+ *  @param addr - address to be written
+ *  @param value - value to be written (restored to the MDR)
+ */
+void undo_mem_write (LC3_WORD addr, LC3_WORD value);
+
+/** Undo the most recent instruction. The PC is left pointing at the
+ *  instruction, so executing forward repeats it.
+ *  @param ir - if not NULL, the instruction that was undone is stored here
+ *  @return true if an instruction was undone, false if the log is empty
+ */
+bool undo_step (LC3_WORD* ir);
+
+#endif /* __UNDO_H__ */
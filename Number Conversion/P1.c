@@ -8,6 +8,13 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL
+#endif
 
 void computeCircle(double radius, double *addressOfArea)
 {
@@ -45,14 +52,370 @@ void computePentagon(double side, double *addressOfArea)
     *addressOfArea = result;
 }
 
+// Batch mode
+//
+// ./P1 -f <in> [out] reads records of four doubles (circle radius, triangle,
+// square and pentagon sides, the same order as the command line) and writes
+// the four areas of each record. A file whose name ends in ".bin" holds raw
+// doubles in host byte order; any other file is CSV, one record per line.
+// Output goes to stdout as CSV when no out file is given.
+//
+// ./P1 -g <count> <out> writes count random records to test with.
+//
+// A malformed or incomplete record stops the run with an error; the records
+// before it are written.
+//
+// Records are read CHUNK at a time into one array per shape (structure of
+// arrays), so each shape is a straight multiply over contiguous doubles.
+// Parsing and the area loops are split across threads when built with
+// -fopenmp.
+
+#define SHAPES 4
+#define CHUNK  (1 << 16)
+#define BLOCK  4096
+#define SLOT   128  // room for one formatted CSV output record
+
+// Same constants as the compute functions above, square is exact with 1.0
+static const double areaFactor[SHAPES] = { 3.141593, 0.433013, 1.0, 1.720477 };
+
+typedef struct {
+    double *side[SHAPES];  // input, one array per shape
+    double *area[SHAPES];  // output, one array per shape
+} chunk_t;
+
+static bool hasSuffix(const char *name, const char *suffix)
+{
+    size_t len = strlen(name);
+    size_t slen = strlen(suffix);
+    return (len >= slen) && (strcmp(name + len - slen, suffix) == 0);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// area[i] = (factor * side[i]) * side[i], the order used by computeCircle()
+static void scaleSquares(const double *side, double *area, int count,
+                         double factor)
+{
+    for (int i = 0; i < count; i++)
+        area[i] = factor * side[i] * side[i];
+}
+
+#ifdef HAVE_AVX2_KERNEL
+// The same loop four doubles at a time. The area is a product of three
+// terms, so there is no add for a fused multiply add to absorb; two
+// multiplies keep the results identical to scaleSquares().
+__attribute__((target("avx2")))
+static void scaleSquaresAVX2(const double *side, double *area, int count,
+                             double factor)
+{
+    __m256d k = _mm256_set1_pd(factor);
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256d s0 = _mm256_loadu_pd(side + i);
+        __m256d s1 = _mm256_loadu_pd(side + i + 4);
+        _mm256_storeu_pd(area + i, _mm256_mul_pd(_mm256_mul_pd(k, s0), s0));
+        _mm256_storeu_pd(area + i + 4, _mm256_mul_pd(_mm256_mul_pd(k, s1), s1));
+    }
+    scaleSquares(side + i, area + i, count - i, factor);
+}
+#endif
+
+typedef void (*kernel_t)(const double *, double *, int, double);
+
+static kernel_t pickKernel(void)
+{
+#ifdef HAVE_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2"))
+        return scaleSquaresAVX2;
+#endif
+    return scaleSquares;
+}
+
+static void computeChunk(chunk_t *c, int count, kernel_t kernel)
+{
+    int blocks = (count + BLOCK - 1) / BLOCK;
+
+#if defined(_OPENMP)
+#pragma omp parallel for collapse(2) schedule(static)
+#endif
+    for (int s = 0; s < SHAPES; s++)
+        for (int b = 0; b < blocks; b++) {
+            int first = b * BLOCK;
+            int n = (count - first < BLOCK) ? count - first : BLOCK;
+            kernel(c->side[s] + first, c->area[s] + first, n, areaFactor[s]);
+        }
+}
+
+// Parse the four values of one CSV line, false if it is malformed
+static bool parseLine(const char *line, chunk_t *c, int i)
+{
+    char *end;
+
+    for (int s = 0; s < SHAPES; s++) {
+        c->side[s][i] = strtod(line, &end);
+        if (end == line)
+            return false;
+        while (*end == ' ' || *end == '\t')
+            end++;
+        if (s < SHAPES - 1) {
+            if (*end != ',')
+                return false;
+            end++;
+        }
+        line = end;
+    }
+    return (*line == '\n') || (*line == '\r') || (*line == '\0');
+}
+
+// Read up to CHUNK CSV records. buf holds *have bytes, the start of which
+// may be left over from the last call. Returns the number of records. If a
+// record is malformed, *badLine is set to its number and only the records
+// before it are returned.
+static int readCSV(FILE *in, char *buf, size_t bufSize, size_t *have,
+                   chunk_t *c, const char **lines, long firstLine,
+                   long *badLine)
+{
+    size_t got = fread(buf + *have, 1, bufSize - 1 - *have, in);
+    size_t len = *have + got;
+    int count = 0;
+    char *p = buf;
+    char *end = buf + len;
+
+    buf[len] = '\0';
+    while (count < CHUNK && p < end) {
+        char *nl = memchr(p, '\n', end - p);
+        if (nl == NULL) {
+            if (!feof(in) && !ferror(in))
+                break;  // partial line, finish it next time
+            nl = end;   // last line has no newline
+        }
+        *nl = '\0';
+        if (nl > p && !(nl == p + 1 && *p == '\r'))
+            lines[count++] = p;
+        p = nl + 1;
+    }
+    if (p > end)
+        p = end;
+
+    int bad = count;  // the first malformed record
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) reduction(min:bad)
+#endif
+    for (int i = 0; i < count; i++)
+        if (i < bad && !parseLine(lines[i], c, i))
+            bad = i;
+
+    if (bad < count) {
+        *badLine = firstLine + bad + 1;
+        return bad;
+    }
+
+    *have = end - p;
+    memmove(buf, p, *have);
+    if (count == 0 && *have == bufSize - 1)
+        *badLine = firstLine + 1;  // a line longer than the buffer
+    return count;
+}
+
+// Read up to CHUNK binary records and spread them into the side arrays.
+// Returns the number of complete records. If the file ends inside a record,
+// *badLine is set to its number.
+static int readBinary(FILE *in, double *records, chunk_t *c, long firstRecord,
+                      long *badLine)
+{
+    size_t bytes = fread(records, 1, (size_t) CHUNK * SHAPES * sizeof(double),
+                         in);
+    int count = (int) (bytes / (SHAPES * sizeof(double)));
+
+    if (bytes % (SHAPES * sizeof(double)) != 0)
+        *badLine = firstRecord + count + 1;
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < count; i++)
+        for (int s = 0; s < SHAPES; s++)
+            c->side[s][i] = records[i * SHAPES + s];
+    return count;
+}
+
+static bool writeChunk(FILE *out, bool binary, chunk_t *c, int count,
+                       double *records, char *text)
+{
+    if (binary) {
+        for (int i = 0; i < count; i++)
+            for (int s = 0; s < SHAPES; s++)
+                records[i * SHAPES + s] = c->area[s][i];
+        return fwrite(records, SHAPES * sizeof(double), count, out)
+               == (size_t) count;
+    }
+
+    // format each record into its own slot in parallel, then close the gaps
+    int *lens = (int *) records;
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < count; i++)
+        lens[i] = snprintf(text + (size_t) i * SLOT, SLOT,
+                           "%.5f,%.5f,%.5f,%.5f\n", c->area[0][i],
+                           c->area[1][i], c->area[2][i], c->area[3][i]);
+
+    size_t len = 0;
+    for (int i = 0; i < count; i++) {
+        if (lens[i] >= SLOT) {  // huge values, write what is done so far
+            if (fwrite(text, 1, len, out) != len
+                || fprintf(out, "%.5f,%.5f,%.5f,%.5f\n", c->area[0][i],
+                           c->area[1][i], c->area[2][i], c->area[3][i]) < 0)
+                return false;
+            len = 0;
+            continue;
+        }
+        memmove(text + len, text + (size_t) i * SLOT, lens[i]);
+        len += lens[i];
+    }
+    return fwrite(text, 1, len, out) == len;
+}
+
+static int batch(const char *inName, const char *outName)
+{
+    bool binIn = hasSuffix(inName, ".bin");
+    bool binOut = (outName != NULL) && hasSuffix(outName, ".bin");
+    FILE *in = fopen(inName, binIn ? "rb" : "r");
+    FILE *out = (outName == NULL) ? stdout : fopen(outName, binOut ? "wb" : "w");
+
+    if (in == NULL || out == NULL) {
+        fprintf(stderr, "cannot open %s\n", (in == NULL) ? inName : outName);
+        if (in != NULL)
+            fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    size_t bufSize = (size_t) CHUNK * 128;
+    chunk_t c;
+    double *records = malloc((size_t) CHUNK * SHAPES * sizeof(double));
+    char *buf = malloc(bufSize);
+    char *text = malloc((size_t) CHUNK * SLOT);
+    const char **lines = malloc(CHUNK * sizeof(char *));
+    kernel_t kernel = pickKernel();
+    size_t have = 0;
+    long total = 0, badLine = 0;
+    double compute = 0.0, start = now();
+    int count, status = EXIT_SUCCESS;
+    bool allocated = records && buf && text && lines;
+
+    for (int s = 0; s < SHAPES; s++) {
+        c.side[s] = malloc(CHUNK * sizeof(double));
+        c.area[s] = malloc(CHUNK * sizeof(double));
+        allocated = allocated && c.side[s] && c.area[s];
+    }
+    if (!allocated) {
+        fprintf(stderr, "cannot allocate the buffers for %s\n", inName);
+        status = EXIT_FAILURE;
+    }
+
+    // a bad record ends the run after the records before it are written
+    while (allocated && badLine == 0
+           && (count = binIn ? readBinary(in, records, &c, total, &badLine)
+                             : readCSV(in, buf, bufSize, &have, &c, lines,
+                                       total, &badLine)) > 0) {
+        double t = now();
+        computeChunk(&c, count, kernel);
+        compute += now() - t;
+        if (!writeChunk(out, binOut, &c, count, records, text)) {
+            fprintf(stderr, "cannot write %s\n",
+                    outName ? outName : "stdout");
+            status = EXIT_FAILURE;
+            break;
+        }
+        total += count;
+    }
+
+    if (ferror(in)) {
+        fprintf(stderr, "cannot read %s\n", inName);
+        status = EXIT_FAILURE;
+    } else if (badLine != 0 && status == EXIT_SUCCESS) {
+        fprintf(stderr, binIn ? "%s: record %ld is incomplete\n"
+                              : "%s: record %ld is not four comma separated "
+                                "numbers\n", inName, badLine);
+        status = EXIT_FAILURE;
+    }
+
+    if (allocated) {
+        double elapsed = now() - start;
+        fprintf(stderr, "%ld records in %.3f s: %.0f records/sec "
+                "(%.0f records/sec in the %s kernel)\n", total, elapsed,
+                total / (elapsed > 0 ? elapsed : 1e-9),
+                total / (compute > 0 ? compute : 1e-9),
+                (kernel == scaleSquares) ? "scalar" : "AVX2");
+    }
+
+    for (int s = 0; s < SHAPES; s++) {
+        free(c.side[s]);
+        free(c.area[s]);
+    }
+    free(records);
+    free(buf);
+    free(text);
+    free(lines);
+    fclose(in);
+    if (out != stdout && fclose(out) != 0 && status == EXIT_SUCCESS) {
+        fprintf(stderr, "cannot write %s\n", outName);
+        status = EXIT_FAILURE;
+    }
+    return status;
+}
+
+static int generate(long count, const char *outName)
+{
+    bool binary = hasSuffix(outName, ".bin");
+    FILE *out = fopen(outName, binary ? "wb" : "w");
+
+    if (out == NULL) {
+        fprintf(stderr, "cannot open %s\n", outName);
+        return EXIT_FAILURE;
+    }
+
+    srand(270);
+    for (long i = 0; i < count; i++) {
+        double record[SHAPES];
+        for (int s = 0; s < SHAPES; s++)
+            record[s] = rand() / (RAND_MAX / 1000.0);
+        if (binary)
+            fwrite(record, sizeof(record), 1, out);
+        else
+            fprintf(out, "%.6f,%.6f,%.6f,%.6f\n", record[0], record[1],
+                    record[2], record[3]);
+    }
+    bool ok = !ferror(out);
+    if (fclose(out) != 0 || !ok) {
+        fprintf(stderr, "cannot write %s\n", outName);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
 int main (int argc, char *argv[])
 {
     static double input[4];
     static double output[4];
 
+    /* batch modes */
+    if (argc >= 3 && argc <= 4 && strcmp(argv[1], "-f") == 0)
+        return batch(argv[2], (argc == 4) ? argv[3] : NULL);
+    if (argc == 4 && strcmp(argv[1], "-g") == 0)
+        return generate(atol(argv[2]), argv[3]);
+
     /* check if there are 4 inputs */
     if (argc != 5) {
 	   printf("usage: ./P1 <double> <double> <double> <double>\n");
+	   printf("       ./P1 -f <in.csv|in.bin> [out.csv|out.bin]\n");
+	   printf("       ./P1 -g <count> <out.csv|out.bin>\n");
 	   return EXIT_FAILURE;
 	}
     /* change from String to double */
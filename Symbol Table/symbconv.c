@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Debug.h"
+#include "symbfile.h"
+
+/** @file symbconv.c
+ *  @brief Convert symbol files between the text (.sym) and binary (.symb)
+ *  formats, and query binary files
+ *  @details To understand the usage, run the program with no arguments.
+ *  The direction of a conversion is chosen by the suffix of the output file.
+ */
+
+/** Print a usage statement describing how program is used, and exit */
+static void usage (void) {
+  puts("Usage: symbconv <in.sym|in.symb> <out.symb|out.sym> - convert");
+  puts("       symbconv -q <file.symb> <name|xADDR>           - look up");
+  exit(1);
+}
+
+static int has_suffix (const char* fileName, const char* suffix) {
+  size_t len  = strlen(fileName);
+  size_t slen = strlen(suffix);
+  return (len >= slen) && (strcmp(fileName + len - slen, suffix) == 0);
+}
+
+/** Look up a name, or an address given as xADDR, in place */
+static int query (const char* fileName, const char* what) {
+  symb_file_t* symb = symb_open(fileName);
+
+  if (symb == NULL) {
+    printf("%s is not a .symb file\n", fileName);
+    return 1;
+  }
+
+  if (((what[0] == 'x') || (what[0] == 'X')) && what[1]
+      && (strspn(what + 1, "0123456789abcdefABCDEF") == strlen(what + 1))) {
+    int         addr  = (int) strtol(what + 1, NULL, 16);
+    const char* label = symb_find_by_addr(symb, addr);
+    printf("x%04X %s\n", addr, label ? label : "NULL");
+  }
+  else {
+    int addr = symb_find_by_name(symb, what);
+    if (addr < 0)
+      printf("%s NULL\n", what);
+    else
+      printf("%s x%04X\n", what, addr);
+  }
+
+  symb_close(symb);
+  return 0;
+}
+
+/** Entry point of the program
+ * @param argc count of arguments, will always be at least 1
+ * @param argv array of parameters to program argv[0] is the name of
+ * the program, so additional parameters will begin at index 1.
+ * @return 0 the Linux convention for success.
+ */
+int main (int argc, const char* argv[]) {
+  debugInit(&argc, argv);
+
+  if (argc != 3 && argc != 4)
+    usage();
+
+  if (strcmp(argv[1], "-q") == 0) {
+    if (argc != 4)
+      usage();
+    return query(argv[2], argv[3]);
+  }
+  if (argc != 3)
+    usage();
+
+  const char*  in     = argv[1];
+  const char*  out    = argv[2];
+  sym_table_t* symTab = symbol_init(997);
+  symb_file_t* symb   = symb_open(in);
+
+  if (symb) {
+    symb_load(symb, symTab);
+    symb_close(symb);
+  }
+  else {
+    FILE* f = fopen(in, "r");
+    if (f == NULL) {
+      printf("cannot read %s\n", in);
+      return 1;
+    }
+    symb_read_text(f, symTab);
+    fclose(f);
+  }
+
+  int failed;
+  if (has_suffix(out, ".symb")) {
+    failed = symb_write(out, symTab);
+  }
+  else {
+    FILE* f = fopen(out, "w");
+    if ((failed = (f == NULL)) == 0) {
+      symb_write_text(f, symTab);
+      failed = (fclose(f) != 0);
+    }
+  }
+
+  if (failed)
+    printf("cannot write %s\n", out);
+  else
+    printf("%d symbols written to %s\n", symbol_size(symTab), out);
+
+  symbol_term(symTab);
+  return failed;
+}
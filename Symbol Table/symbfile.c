@@ -0,0 +1,258 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Debug.h"
+#include "symbfile.h"
+
+/** @file symbfile.c
+ *  @brief Implementation of the symbfile.h interface
+ *  @details The file is written with <code>fwrite()</code> of the structures
+ *  in symbfile.h, so it is in the byte order of the host. A file from a
+ *  host of the other byte order is rejected when opened: its byteOrder
+ *  field does not match.
+ */
+
+/** a mapped .symb file */
+struct symb_file {
+  const char*          base;     /**< start of the mapping   */
+  size_t               size;     /**< length of the mapping  */
+  const symb_header_t* header;   /**< the header             */
+  const symb_entry_t*  entries;  /**< address index          */
+  const symb_slot_t*   slots;    /**< name index             */
+  const char*          pool;     /**< string pool            */
+};
+
+/** FNV-1a hash of a name folded to lower case (part of the file format) */
+static uint32_t symb_hash (const char* name, size_t len) {
+  uint32_t hash = 2166136261u;
+
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = name[i];
+    hash ^= c + (((unsigned) (c - 'A') < 26) ? 0x20 : 0);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+int symb_write (const char* fileName, sym_table_t* symTab) {
+  symbol_t* const* list  = symbol_view(symTab, ADDR);
+  uint32_t         count = symbol_size(symTab);
+  uint32_t         numSlots = 8;
+  uint32_t         poolSize = 0;
+
+  while (numSlots < 2 * count) /* load factor at most 1/2 */
+    numSlots *= 2;
+
+  for (uint32_t i = 0; i < count; i++) {
+    if ((list[i]->addr < 0) || (list[i]->addr > 0xFFFF))
+      return 1;
+    poolSize += strlen(list[i]->name) + 1;
+  }
+
+  symb_header_t header   = { SYMB_MAGIC, SYMB_VERSION, count };
+  symb_entry_t* entries  = malloc((count + 1) * sizeof(symb_entry_t));
+  symb_slot_t*  slots    = calloc(numSlots, sizeof(symb_slot_t));
+  uint32_t      poolNext = 0;
+
+  header.entryOffset = sizeof(symb_header_t);
+  header.numSlots    = numSlots;
+  header.slotOffset  = header.entryOffset + count * sizeof(symb_entry_t);
+  header.poolOffset  = header.slotOffset + numSlots * sizeof(symb_slot_t);
+  header.poolSize    = poolSize;
+  header.byteOrder   = SYMB_BYTE_ORDER;
+
+  for (uint32_t i = 0; i < count; i++) {
+    size_t   len  = strlen(list[i]->name);
+    uint32_t hash = symb_hash(list[i]->name, len);
+    uint32_t slot = hash & (numSlots - 1);
+
+    entries[i].name = poolNext;
+    entries[i].addr = list[i]->addr;
+    entries[i].len  = len;
+    poolNext += len + 1;
+
+    while (slots[slot].entry)
+      slot = (slot + 1) & (numSlots - 1);
+    slots[slot].hash  = hash;
+    slots[slot].entry = i + 1;
+  }
+
+  FILE* f  = fopen(fileName, "wb");
+  int   ok = (f != NULL);
+
+  if (ok) {
+    ok &= fwrite(&header, sizeof(header), 1, f) == 1;
+    ok &= fwrite(entries, sizeof(symb_entry_t), count, f) == count;
+    ok &= fwrite(slots, sizeof(symb_slot_t), numSlots, f) == numSlots;
+    for (uint32_t i = 0; i < count; i++)
+      ok &= fwrite(list[i]->name, entries[i].len + 1, 1, f) == 1;
+    ok &= (fclose(f) == 0);
+  }
+
+  free(entries);
+  free(slots);
+  return ! ok;
+}
+
+/** Check that every name lies in the pool and ends with a 0 byte, and that
+ *  every slot refers to an entry with at most count slots in use */
+static int symb_valid_index (const symb_header_t* h, const char* base) {
+  const symb_entry_t* entries = (const symb_entry_t*) (base + h->entryOffset);
+  const symb_slot_t*  slots   = (const symb_slot_t*) (base + h->slotOffset);
+  const char*         pool    = base + h->poolOffset;
+  uint32_t            used    = 0;
+
+  for (uint32_t i = 0; i < h->count; i++) {
+    if (((uint64_t) entries[i].name + entries[i].len >= h->poolSize)
+        || (pool[entries[i].name + entries[i].len] != 0))
+      return 0;
+  }
+
+  for (uint32_t i = 0; i < h->numSlots; i++) {
+    if (slots[i].entry > h->count)
+      return 0;
+    used += (slots[i].entry != 0);
+  }
+  return used <= h->count;
+}
+
+symb_file_t* symb_open (const char* fileName) {
+  int         fd = open(fileName, O_RDONLY);
+  struct stat st;
+  const char* base;
+
+  if (fd < 0)
+    return NULL;
+
+  if ((fstat(fd, &st) != 0) || (st.st_size < (off_t) sizeof(symb_header_t))) {
+    close(fd);
+    return NULL;
+  }
+
+  base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+    return NULL;
+
+  const symb_header_t* h    = (const symb_header_t*) base;
+  uint64_t             size = st.st_size;
+
+  /* every part must lie inside the file, and the name index must have an
+     empty slot to end a search */
+  if ((memcmp(h->magic, SYMB_MAGIC, sizeof(h->magic)) != 0)
+      || (h->version != SYMB_VERSION) || (h->byteOrder != SYMB_BYTE_ORDER)
+      || (h->numSlots == 0) || (h->numSlots & (h->numSlots - 1))
+      || (h->numSlots <= h->count)
+      || (h->entryOffset % sizeof(uint32_t))
+      || (h->slotOffset % sizeof(uint32_t))
+      || (h->entryOffset + (uint64_t) h->count * sizeof(symb_entry_t) > size)
+      || (h->slotOffset + (uint64_t) h->numSlots * sizeof(symb_slot_t) > size)
+      || ((uint64_t) h->poolOffset + h->poolSize > size)
+      || ! symb_valid_index(h, base)) {
+    debug("%s is not a valid .symb file", fileName);
+    munmap((void*) base, st.st_size);
+    return NULL;
+  }
+
+  symb_file_t* symb = malloc(sizeof(symb_file_t));
+  symb->base    = base;
+  symb->size    = st.st_size;
+  symb->header  = h;
+  symb->entries = (const symb_entry_t*) (base + h->entryOffset);
+  symb->slots   = (const symb_slot_t*) (base + h->slotOffset);
+  symb->pool    = base + h->poolOffset;
+  return symb;
+}
+
+void symb_close (symb_file_t* symb) {
+  if (symb) {
+    munmap((void*) symb->base, symb->size);
+    free(symb);
+  }
+}
+
+int symb_count (symb_file_t* symb) {
+  return symb->header->count;
+}
+
+const char* symb_name (symb_file_t* symb, int i) {
+  return symb->pool + symb->entries[i].name;
+}
+
+int symb_addr (symb_file_t* symb, int i) {
+  return symb->entries[i].addr;
+}
+
+const char* symb_find_by_addr (symb_file_t* symb, int addr) {
+  int lo = 0, hi = symb->header->count; /* first entry with addr >= addr */
+
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (symb->entries[mid].addr < addr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if ((lo < (int) symb->header->count) && (symb->entries[lo].addr == addr))
+    return symb_name(symb, lo);
+  return NULL;
+}
+
+int symb_find_by_name (symb_file_t* symb, const char* name) {
+  size_t   len  = strlen(name);
+  uint32_t hash = symb_hash(name, len);
+  uint32_t mask = symb->header->numSlots - 1;
+
+  for (uint32_t i = hash & mask; symb->slots[i].entry; i = (i + 1) & mask) {
+    if (symb->slots[i].hash == hash) {
+      const symb_entry_t* e = &symb->entries[symb->slots[i].entry - 1];
+      if ((e->len == len) && (strncasecmp(symb->pool + e->name, name, len) == 0))
+        return e->addr;
+    }
+  }
+  return -1;
+}
+
+int symb_load (symb_file_t* symb, sym_table_t* symTab) {
+  int added = 0;
+
+  for (uint32_t i = 0; i < symb->header->count; i++)
+    added += symbol_add(symTab, symb_name(symb, i), symb_addr(symb, i));
+  return added;
+}
+
+int symb_read_text (FILE* f, sym_table_t* symTab) {
+  char buf[100];
+  char sym[81];
+  int  addr, adding = 0, added = 0;
+
+  while (fgets(buf, sizeof(buf), f) != NULL) {
+    if (adding) {
+      if (sscanf(buf, "%*s%80s%x", sym, &addr) != 2)
+        break;
+      added += symbol_add(symTab, sym, addr);
+    }
+    else if ((sscanf(buf, "%*s%*s%80s", sym) == 1)
+             && (strcmp(sym, "------------") == 0)) {
+      adding = 1;
+    }
+  }
+  return added;
+}
+
+void symb_write_text (FILE* f, sym_table_t* symTab) {
+  symbol_t* const* list = symbol_view(symTab, ADDR);
+
+  fprintf(f, "// Symbol table\n");
+  fprintf(f, "// Scope level 0:\n");
+  fprintf(f, "//\tSymbol Name       Page Address\n");
+  fprintf(f, "//\t----------------  ------------\n");
+  for (int i = 0; list[i]; i++)
+    fprintf(f, "//\t%-16s  %04X\n", list[i]->name, list[i]->addr);
+}
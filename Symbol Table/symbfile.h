@@ -0,0 +1,122 @@
+#ifndef __SYMBFILE_H__
+#define __SYMBFILE_H__
+
+/** @file symbfile.h
+ *  @brief Defines the interface to binary symbol files (.symb)
+ *  @details A .symb file holds the same information as a text .sym file,
+ *  laid out so that it can be mapped into memory with <code>mmap()</code>
+ *  and searched where it lies, with no parsing.
+ *  <p>
+ *  All values are in the byte order of the host that wrote the file. The
+ *  header holds SYMB_BYTE_ORDER, so a file written on a host of the other
+ *  byte order is rejected when it is opened. The file is, in order:
+ *  <ol>
+ *  <li>a header (<code>symb_header_t</code>)</li>
+ *  <li>the entries (<code>symb_entry_t</code>), sorted by address and then
+ *  by name. This is the address index: a label is found by address with a
+ *  binary search.</li>
+ *  <li>the name index: a power of 2 number of <code>symb_slot_t</code>,
+ *  an open addressing (linear probing) hash table of the case folded names.
+ *  The hash is FNV-1a of the name in lower case, so the file does not
+ *  depend on how symbol.c hashes.</li>
+ *  <li>the string pool: every name, as given, terminated by a 0 byte.</li>
+ *  </ol>
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "symbol.h"
+
+/** the first 8 bytes of a .symb file */
+#define SYMB_MAGIC   "LC3SYMB"
+
+/** the version of the format described here */
+#define SYMB_VERSION 2
+
+/** the byte order marker, which reads as 0x04030201 on a foreign host */
+#define SYMB_BYTE_ORDER 0x01020304u
+
+/** The start of a .symb file. Offsets are in bytes from the file start. */
+typedef struct symb_header {
+  char     magic[8];     /**< SYMB_MAGIC, including the 0 byte       */
+  uint32_t version;      /**< SYMB_VERSION                           */
+  uint32_t count;        /**< number of symbols                      */
+  uint32_t entryOffset;  /**< offset of the entries                  */
+  uint32_t numSlots;     /**< length of the name index (power of 2)  */
+  uint32_t slotOffset;   /**< offset of the name index               */
+  uint32_t poolOffset;   /**< offset of the string pool              */
+  uint32_t poolSize;     /**< bytes in the string pool               */
+  uint32_t byteOrder;    /**< SYMB_BYTE_ORDER                        */
+} symb_header_t;
+
+/** One symbol */
+typedef struct symb_entry {
+  uint32_t name;         /**< offset of the name in the string pool  */
+  uint16_t addr;         /**< LC3 address                            */
+  uint16_t len;          /**< length of the name                     */
+} symb_entry_t;
+
+/** One entry of the name index */
+typedef struct symb_slot {
+  uint32_t hash;         /**< hash of the folded name                */
+  uint32_t entry;        /**< index of the entry + 1, 0 means empty  */
+} symb_slot_t;
+
+/** A .symb file mapped into memory (opaque) */
+typedef struct symb_file symb_file_t;
+
+/** Write the symbols of a table as a .symb file
+ *  @param fileName - name of the file to create
+ *  @param symTab - the symbols to write (addresses must be 0 - xFFFF)
+ *  @return 0 on success, non-zero on failure
+ */
+int symb_write (const char* fileName, sym_table_t* symTab);
+
+/** Map a .symb file into memory. The header and every entry and slot are
+ *  checked, so a corrupt file is rejected instead of being read out of
+ *  bounds.
+ *  @param fileName - the file
+ *  @return a handle for the file, or NULL if it is not a valid .symb file
+ */
+symb_file_t* symb_open (const char* fileName);
+
+/** Unmap a file opened by <code>symb_open()</code> */
+void symb_close (symb_file_t* symb);
+
+/** Return the number of symbols in the file */
+int symb_count (symb_file_t* symb);
+
+/** Return the name of the i'th symbol (in address order) */
+const char* symb_name (symb_file_t* symb, int i);
+
+/** Return the address of the i'th symbol (in address order) */
+int symb_addr (symb_file_t* symb, int i);
+
+/** Find a label by its address
+ *  @return the label (the first in name order, if several share the
+ *  address), or NULL if there is none. The string is in the mapped file.
+ */
+const char* symb_find_by_addr (symb_file_t* symb, int addr);
+
+/** Find the address of a name (case insensitive)
+ *  @return the address, or -1 if the name is not in the file
+ */
+int symb_find_by_name (symb_file_t* symb, const char* name);
+
+/** Add every symbol in the file to a symbol table
+ *  @return the number of symbols added
+ */
+int symb_load (symb_file_t* symb, sym_table_t* symTab);
+
+/** Read a text symbol file (as written by the assembler) into a table.
+ *  Lines after the <code>------------</code> line are
+ *  <code>//&lt;tab&gt;NAME  ADDR</code> with ADDR in hex.
+ *  @return the number of symbols added
+ */
+int symb_read_text (FILE* f, sym_table_t* symTab);
+
+/** Write a table as a text symbol file, in address order */
+void symb_write_text (FILE* f, sym_table_t* symTab);
+
+#endif /* __SYMBFILE_H__ */
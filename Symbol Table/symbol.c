@@ -1,4 +1,8 @@
-#include <ctype.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,6 +11,12 @@
 #include "Debug.h"
 #include "symbol.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /** @file symbol.c
  *  @brief You will modify this file and implement the symbol.h interface
  *  @details Your implementation of the functions defined in symbol.h.
@@ -15,6 +25,67 @@
  *  within this file. The reference implementation added approximately
  *  110 lines of code to this file. This count includes lines containing
  *  only a single closing bracket (}).
+ *  <p>
+ *  The hash table uses open addressing with Robin Hood probing. Each slot is
+ *  8 bytes: the 32 bit hash of the name and the index of the node holding
+ *  the symbol. A probe compares hashes within the slot array and only
+ *  touches a node (and its name) when the hashes match, so a lookup is
+ *  usually one or two cache misses. Robin Hood insertion keeps the probe
+ *  sequences short: an entry that is further from its home slot than the
+ *  one occupying a slot takes the slot, and the displaced entry moves on.
+ *  <p>
+ *  Nodes are allocated in blocks that never move, so the
+ *  <code>symbol_t*</code> returned by symbol_find_by_name() stays valid
+ *  while the table grows. Names are copied into an arena owned by the
+ *  table: a list of large chunks that are filled from front to back. Adding
+ *  a symbol does no allocation except when a block or chunk fills, and
+ *  symbol_reset() simply rewinds the node count and the arena, keeping the
+ *  memory for the next symbols.
+ *  <p>
+ *  Labels are found by address with a two level radix table: the high 8 bits
+ *  of the address select a page of 256 <code>char*</code>, allocated the
+ *  first time a symbol is added in that range. A table with a few symbols
+ *  uses a few pages instead of a 512 KB array, and a lookup is still two
+ *  array references.
+ *  <p>
+ *  When the load factor reaches 7/8 the table doubles. Rather than moving
+ *  every entry at once, the old slot array is kept and each later
+ *  symbol_add() moves a few of its slots into the new array. Until the move
+ *  is complete, a search that misses in the new array also looks in the old
+ *  one. The old array is only read during the move, so entries that have
+ *  already been copied are found in either array; symbol_iterate() visits
+ *  the new array and the part of the old one that has not been copied yet.
+ *  <p>
+ *  The ordered lists returned by symbol_order() and symbol_view() are kept
+ *  in the table and built only when asked for. Nodes are numbered in the
+ *  order they were added, so the symbols added since the name ordered list
+ *  was last brought up to date are simply the nodes past its length: they
+ *  are sorted on their own and merged in. The address ordered list is made
+ *  from the name ordered list with a two pass radix sort on the 16 bit
+ *  address. The sort is stable, so symbols at the same address stay in name
+ *  order as compare_addresses() requires.
+ *  <p>
+ *  Names are case insensitive. Each name is stored twice in the arena: as
+ *  given, and folded to lower case. A name being looked up is folded once
+ *  (16 or 32 bytes at a time with SSE2/AVX2 when available) and hashed a
+ *  word at a time; entries are compared by hash, then length, then a
+ *  memcmp() of the folded bytes.
+ *  <p>
+ *  The name ordered list doubles as a prefix index: the names starting with
+ *  a prefix are next to each other in it, so symbol_find_by_prefix() finds
+ *  them with two binary searches over the folded names.
+ *  <p>
+ *  A table made by symbol_init_shared() may be searched by any number of
+ *  threads while another adds to it. Writers are serialized by a mutex and
+ *  bump a sequence count before and after changing the table (a seqlock).
+ *  Readers take no lock and write nothing shared: they note the count, search,
+ *  and search again if the count changed or was odd. Nothing a reader can
+ *  reach is ever freed or moved while the table exists: slot arrays and
+ *  block lists replaced by growth are kept on a retired list until
+ *  symbol_term(), and the fields readers use are stored in an order that
+ *  keeps a search in bounds even when it sees a mix of old and new values
+ *  (the new slot array before the larger capacity, the node before the slot
+ *  that refers to it). The ordered lists and symbol_iterate() take the mutex.
  * <p>
  * @author <b>Your name</b> goes here
  */
@@ -22,190 +93,594 @@
 /** size of LC3 memory */
 #define LC3_MEMORY_SIZE  (1 << 16)
 
-/** Provide prototype for () */
-char *strdup(const char *s);
+/** log2 of the number of nodes in a block */
+#define NODE_BLOCK_BITS  8
+
+/** number of nodes in a block */
+#define NODE_BLOCK       (1 << NODE_BLOCK_BITS)
+
+/** log2 of the number of addresses in a page of the address index */
+#define ADDR_PAGE_BITS   8
+
+/** number of addresses in a page of the address index */
+#define ADDR_PAGE        (1 << ADDR_PAGE_BITS)
+
+/** number of pages in the address index */
+#define ADDR_PAGES       (LC3_MEMORY_SIZE / ADDR_PAGE)
+
+/** old slots moved to the new array by each symbol_add() while growing */
+#define MIGRATE_STEP     8
+
+/** names up to this length are folded into a buffer on the stack */
+#define KEY_BUF          256
+
+/** minimum size of an arena chunk */
+#define ARENA_CHUNK      (64 * 1024)
+
+/** a chunk of the name arena */
+typedef struct chunk {
+  struct chunk* next;   /**< next chunk in the arena (kept on reset) */
+  size_t        size;   /**< bytes available in data                 */
+  char          data[]; /**< the names                               */
+} chunk_t;
+
+/** bump allocator for names */
+typedef struct arena {
+  chunk_t* first;       /**< first chunk, NULL if none allocated     */
+  chunk_t* cur;         /**< chunk being filled                      */
+  size_t   used;        /**< bytes used in cur                       */
+} arena_t;
 
-/** defines data structure used to store nodes in hash table */
+/** defines data structure used to store symbols */
 typedef struct node {
-  struct node* next;     /**< linked list of symbols at same index */
   int          hash;     /**< hash value - makes searching faster  */
+  int          len;      /**< length of the name                   */
+  const char*  folded;   /**< the name in lower case               */
   symbol_t     symbol;   /**< the data the user is interested in   */
 } node_t;
 
+/** a name prepared for searching */
+typedef struct search_key {
+  char*       folded;        /**< lower case, padded with 0 bytes */
+  size_t      len;           /**< length of the name              */
+  uint32_t    hash;          /**< hash of the folded name         */
+  char        buf[KEY_BUF];  /**< folded is here for short names  */
+} search_key_t;
+
+/** a cached ordered list of symbols */
+typedef struct view {
+  symbol_t** list;      /**< NULL terminated list, count entries        */
+  int        count;     /**< symbols in the list                        */
+  int        capacity;  /**< length of list (including the NULL)        */
+} view_t;
+
+/** one entry of the hash table */
+typedef struct slot {
+  uint32_t hash;  /**< hash of the name                          */
+  uint32_t node;  /**< index of node + 1, 0 means the slot is empty */
+} slot_t;
+
 /** defines the data structure for the hash table */
 struct sym_table {
-  int      capacity;    /**< length of hast_table array                  */
-  int      size;        /**< number of symbols (may exceed capacity)     */
-  node_t** hash_table;  /**< array of head of linked list for this index */
-  char**   addr_table;  /**< look up symbols by addr (optional)          */
+  int      capacity;    /**< length of slots array (a power of 2)        */
+  int      size;        /**< number of symbols                           */
+  slot_t*  slots;       /**< the hash table                              */
+  slot_t*  oldSlots;    /**< table being moved into slots, or NULL       */
+  int      oldCapacity; /**< length of oldSlots array                    */
+  int      migrated;    /**< oldSlots[0..migrated-1] have been moved     */
+  node_t** blocks;      /**< nodes, NODE_BLOCK per block                 */
+  int      numBlocks;   /**< blocks in use                               */
+  int      maxBlocks;   /**< allocated length of blocks array            */
+  arena_t  names;       /**< storage for the names                       */
+  view_t   views[3];    /**< symbol_view() lists, indexed by HASH..ADDR  */
+  bool            shared;     /**< made by symbol_init_shared()          */
+  pthread_mutex_t lock;       /**< serializes writers of a shared table  */
+  atomic_uint     seq;        /**< odd while a writer changes the table  */
+  void**          retired;    /**< freed by symbol_term() (shared only)  */
+  int             numRetired; /**< entries in retired                    */
+  char**   addr_table[ADDR_PAGES]; /**< label by addr, pages made on demand */
 };
 
-/** djb hash - found at http://www.cse.yorku.ca/~oz/hash.html
- * tolower() call to make case insensitive.
+/** Convert len bytes to lower case. Only ASCII letters are changed, the
+ *  same as tolower() in the C locale.
+ */
+static void fold (char* dst, const char* src, size_t len) {
+  size_t i = 0;
+
+#if defined(__AVX2__)
+  const __m256i before = _mm256_set1_epi8('A' - 1);
+  const __m256i after  = _mm256_set1_epi8('Z' + 1);
+  const __m256i bit    = _mm256_set1_epi8(0x20);
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i v     = _mm256_loadu_si256((const __m256i*) (src + i));
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, before),
+                                     _mm256_cmpgt_epi8(after, v));
+    v = _mm256_or_si256(v, _mm256_and_si256(upper, bit));
+    _mm256_storeu_si256((__m256i*) (dst + i), v);
+  }
+#elif defined(__SSE2__)
+  const __m128i before = _mm_set1_epi8('A' - 1);
+  const __m128i after  = _mm_set1_epi8('Z' + 1);
+  const __m128i bit    = _mm_set1_epi8(0x20);
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i v     = _mm_loadu_si128((const __m128i*) (src + i));
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, before),
+                                  _mm_cmpgt_epi8(after, v));
+    v = _mm_or_si128(v, _mm_and_si128(upper, bit));
+    _mm_storeu_si128((__m128i*) (dst + i), v);
+  }
+#endif
+
+  for (; i < len; i++) {
+    unsigned char c = src[i];
+    dst[i] = c + (((unsigned) (c - 'A') < 26) ? 0x20 : 0);
+  }
+}
+
+/** Hash a folded name 8 bytes at a time. The name must be followed by
+ *  zero bytes up to a multiple of 8.
+ */
+static int symbol_hash (const char* folded, size_t len) {
+  uint64_t hash = 0x9E3779B97F4A7C15ull ^ len;
+
+  for (size_t i = 0; i < len; i += 8) {
+    uint64_t word;
+    memcpy(&word, folded + i, 8);
+    hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 32;
+  }
+  hash ^= hash >> 29;
+
+  return hash & 0x7FFFFFFF; /* keep 31 bits - avoid negative values */
+}
+
+/** Fold and hash a name. release_key() must be called when done. */
+static void make_key (search_key_t* key, const char* name) {
+  key->len    = strlen(name);
+  key->folded = (key->len + 8 <= KEY_BUF) ? key->buf : malloc(key->len + 8);
+
+  fold(key->folded, name, key->len);
+  memset(key->folded + key->len, 0, 8);
+  key->hash = symbol_hash(key->folded, key->len);
+}
+
+static void release_key (search_key_t* key) {
+  if (key->folded != key->buf)
+    free(key->folded);
+}
+
+/** Allocate len bytes from the arena, moving on to the next chunk (or
+ *  adding one) when the current chunk is full
+ */
+static char* arena_alloc (arena_t* arena, size_t len) {
+  while ((arena->cur == NULL) || (arena->used + len > arena->cur->size)) {
+    chunk_t* next = arena->cur ? arena->cur->next : arena->first;
+
+    if ((next == NULL) || (next->size < len)) {
+      size_t   size  = (len > ARENA_CHUNK) ? len : ARENA_CHUNK;
+      chunk_t* chunk = malloc(sizeof(chunk_t) + size);
+      chunk->size    = size;
+      chunk->next    = next;
+      if (arena->cur)
+        arena->cur->next = chunk;
+      else
+        arena->first = chunk;
+      next = chunk;
+    }
+    arena->cur  = next;
+    arena->used = 0;
+  }
+
+  char* mem = arena->cur->data + arena->used;
+  arena->used += len;
+  return mem;
+}
+
+/** Forget all strings, keeping the chunks for reuse */
+static void arena_rewind (arena_t* arena) {
+  arena->cur  = NULL;
+  arena->used = 0;
+}
+
+/** Release all chunks */
+static void arena_free (arena_t* arena) {
+  while (arena->first) {
+    chunk_t* next = arena->first->next;
+    free(arena->first);
+    arena->first = next;
+  }
+  arena_rewind(arena);
+}
+
+/** Return the node with the given index (0 based) */
+static node_t* get_node (sym_table_t* symTab, uint32_t index) {
+  return &symTab->blocks[index >> NODE_BLOCK_BITS][index & (NODE_BLOCK - 1)];
+}
+
+/** Free memory that is no longer part of the table. A shared table keeps it
+ *  until symbol_term(), since a reader may still be looking at it.
  */
+static void retire (sym_table_t* symTab, void* mem) {
+  if (! symTab->shared || (mem == NULL)) {
+    free(mem);
+    return;
+  }
+  symTab->retired = realloc(symTab->retired,
+                            (symTab->numRetired + 1) * sizeof(void*));
+  symTab->retired[symTab->numRetired++] = mem;
+}
+
+/** Take the writer lock of a shared table */
+static void lock_table (sym_table_t* symTab) {
+  if (symTab->shared)
+    pthread_mutex_lock(&symTab->lock);
+}
+
+static void unlock_table (sym_table_t* symTab) {
+  if (symTab->shared)
+    pthread_mutex_unlock(&symTab->lock);
+}
+
+/** Take the writer lock and tell readers the table is changing */
+static void write_begin (sym_table_t* symTab) {
+  if (symTab->shared) {
+    pthread_mutex_lock(&symTab->lock);
+    atomic_fetch_add_explicit(&symTab->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+  }
+}
+
+static void write_end (sym_table_t* symTab) {
+  if (symTab->shared) {
+    atomic_fetch_add_explicit(&symTab->seq, 1, memory_order_release);
+    pthread_mutex_unlock(&symTab->lock);
+  }
+}
+
+/** Wait until no writer is active and return the sequence count */
+static unsigned read_begin (sym_table_t* symTab) {
+  unsigned seq;
+
+  while ((seq = atomic_load_explicit(&symTab->seq, memory_order_acquire)) & 1)
+    ;
+  return seq;
+}
+
+/** Return true if a writer was active since read_begin() returned seq */
+static bool read_retry (sym_table_t* symTab, unsigned seq) {
+  atomic_thread_fence(memory_order_acquire);
+  return atomic_load_explicit(&symTab->seq, memory_order_relaxed) != seq;
+}
+
+/** Return the node holding a symbol */
+static node_t* symbol_node (const symbol_t* sym) {
+  return (node_t*) ((char*) sym - offsetof(node_t, symbol));
+}
 
-static int symbol_hash (const char* name) {
-  unsigned char* str  = (unsigned char*) name;
-  unsigned long  hash = 5381;
-  int c;
+/** Record the label at an address, allocating its page if needed */
+static void set_label (sym_table_t* symTab, int addr, char* name) {
+  if ((addr < 0) || (addr >= LC3_MEMORY_SIZE))
+    return;
 
-  while ((c = *str++))
-    hash = ((hash << 5) + hash) + tolower(c); /* hash * 33 + c */
+  char*** page = &symTab->addr_table[addr >> ADDR_PAGE_BITS];
+
+  if (*page == NULL) {
+    if (name == NULL)
+      return;
+    char** newPage = calloc(ADDR_PAGE, sizeof(char*));
+    atomic_thread_fence(memory_order_release); /* zeroed before published */
+    *page = newPage;
+  }
+  (*page)[addr & (ADDR_PAGE - 1)] = name;
+}
 
-  c = hash & 0x7FFFFFFF; /* keep 31 bits - avoid negative values */
+/** Return the distance of the entry with the given hash, stored in slot i,
+ *  from its home slot
+ */
+static uint32_t probe_distance (uint32_t mask, uint32_t hash, uint32_t i) {
+  return (i - hash) & mask;
+}
 
-  return c;
+/** Store a slot using Robin Hood insertion. The table must have room. */
+static void insert_slot (slot_t* slots, uint32_t mask, slot_t entry) {
+  uint32_t i    = entry.hash & mask;
+  uint32_t dist = 0;
+
+  while (slots[i].node) {
+    uint32_t other = probe_distance(mask, slots[i].hash, i);
+    if (other < dist) { /* take from the rich, give to the poor */
+      slot_t tmp = slots[i];
+      slots[i]   = entry;
+      entry      = tmp;
+      dist       = other;
+    }
+    i = (i + 1) & mask;
+    dist++;
+  }
+  slots[i] = entry;
+}
+
+/** Find a name in a slot array
+ *  @return the node, or NULL if it is not there
+ */
+static node_t* find_slot (sym_table_t* symTab, slot_t* slots, uint32_t mask,
+                          const search_key_t* key) {
+  uint32_t hash = key->hash;
+  uint32_t i    = hash & mask;
+
+  /* an entry closer to its home than we are to ours ends the search */
+  for (uint32_t dist = 0; ; dist++) {
+    slot_t slot = slots[i]; /* read once, a writer may be changing it */
+    if ((slot.node == 0) || (probe_distance(mask, slot.hash, i) < dist))
+      break;
+    if (slot.hash == hash) {
+      atomic_thread_fence(memory_order_acquire); /* node before its slot */
+      node_t* node = get_node(symTab, slot.node - 1);
+      if ((node->len == key->len)
+          && (memcmp(node->folded, key->folded, key->len) == 0))
+        return node;
+    }
+    i = (i + 1) & mask;
+  }
+  return NULL;
+}
+
+/** Move up to count slots of the old array into the new one, releasing the
+ *  old array when it has all been moved
+ */
+static void migrate (sym_table_t* symTab, int count) {
+  uint32_t mask = symTab->capacity - 1;
+
+  while ((count-- > 0) && (symTab->migrated < symTab->oldCapacity)) {
+    slot_t entry = symTab->oldSlots[symTab->migrated++];
+    if (entry.node)
+      insert_slot(symTab->slots, mask, entry);
+  }
+
+  if (symTab->migrated == symTab->oldCapacity) {
+    slot_t* done = symTab->oldSlots;
+    symTab->oldCapacity = 0;
+    atomic_thread_fence(memory_order_release);
+    symTab->oldSlots    = NULL;
+    symTab->migrated    = 0;
+    retire(symTab, done);
+  }
+}
+
+/** Double the number of slots. The entries are moved by later calls to
+ *  migrate(); the table reaches the next doubling only after at least
+ *  7/8 * capacity more adds, well after the move has completed.
+ */
+static void grow (sym_table_t* symTab) {
+  if (symTab->oldSlots)
+    migrate(symTab, symTab->oldCapacity); /* finish the previous move */
+
+  /* each array is stored before the capacity a reader uses to index it */
+  slot_t* slots = calloc(2 * symTab->capacity, sizeof(slot_t));
+  symTab->migrated    = 0;
+  symTab->oldSlots    = symTab->slots;
+  atomic_thread_fence(memory_order_release);
+  symTab->oldCapacity = symTab->capacity;
+  symTab->slots       = slots;
+  atomic_thread_fence(memory_order_release);
+  symTab->capacity   *= 2;
+  debug("symbol table growing to %d slots", symTab->capacity);
 }
 
 /** @todo implement this function */
 sym_table_t* symbol_init (int capacity) {
   sym_table_t* x = calloc(1, sizeof(sym_table_t));
-  x->capacity = capacity;
+
+  /* room for capacity symbols below the maximum load factor of 7/8 */
+  x->capacity = 8;
+  while (x->capacity < capacity + capacity / 7 + 1)
+    x->capacity *= 2;
+
   x->size = 0;
-  x->addr_table = (char**)calloc(LC3_MEMORY_SIZE, sizeof(char*));
-  x->hash_table = (node_t**)calloc(capacity, sizeof(node_t*));
+  x->slots      = calloc(x->capacity, sizeof(slot_t));
+  return x;
+}
+
+sym_table_t* symbol_init_shared (int capacity) {
+  sym_table_t* x = symbol_init(capacity);
+
+  x->shared = true;
+  pthread_mutex_init(&x->lock, NULL);
   return x;
 }
 
 /** @todo implement this function */
 void symbol_term (sym_table_t* symTab) {
- symbol_reset(symTab);
- free(symTab->hash_table);
- free(symTab->addr_table);
- free(symTab);
-}	
+  if (symTab == NULL)
+    return;
+
+  for (int i = 0; i < symTab->numBlocks; i++)
+    free(symTab->blocks[i]);
+  free(symTab->blocks);
+  arena_free(&symTab->names);
+  free(symTab->slots);
+  free(symTab->oldSlots);
+  for (int i = HASH; i <= ADDR; i++)
+    free(symTab->views[i].list);
+  for (int i = 0; i < ADDR_PAGES; i++)
+    free(symTab->addr_table[i]);
+  for (int i = 0; i < symTab->numRetired; i++)
+    free(symTab->retired[i]);
+  free(symTab->retired);
+  if (symTab->shared)
+    pthread_mutex_destroy(&symTab->lock);
+  free(symTab);
+}
 
 /** @todo implement this function */
 void symbol_reset(sym_table_t* symTab) {
+  write_begin(symTab);
+  for (int i = 0; i < symTab->size; i++)
+    set_label(symTab, get_node(symTab, i)->symbol.addr, NULL);
+
+  slot_t* old = symTab->oldSlots;
+  symTab->oldCapacity = 0;
+  atomic_thread_fence(memory_order_release);
+  symTab->oldSlots    = NULL;
+  symTab->migrated    = 0;
+  retire(symTab, old);
+  memset(symTab->slots, 0, symTab->capacity * sizeof(slot_t));
+  arena_rewind(&symTab->names);
+  for (int i = HASH; i <= ADDR; i++) {
+    symTab->views[i].count = 0;
+    if (symTab->views[i].list)
+      symTab->views[i].list[0] = NULL;
+  }
+  symTab->size = 0;
+  write_end(symTab);
+}
 
- int cap = symTab->capacity - 1;
- for (int i =0; i<cap; i++)
- {   
-   node_t* head = symTab->hash_table[i];
-   while(head!=NULL)
-   {
-     node_t* ref = head;
-     head = head->next;
-     free(ref->symbol.name);
-     free(ref);
-   }
- }
- for(int i = 0; i < ((2^16)-1); i++)
- {
-   char* current = symTab->addr_table[i];
-   free(current);
- }
- /*node_t* x;
- 
- for (int i = 0; i < symTab->capacity; i++)
- {
-     x = symTab->hash_table[i];
-     
-     while(x != NULL)
-     {
-       node_t* ref = x;
-       x = x->next;
-       free(ref->symbol.name);
-       
-       free(ref);
-     }
-   symTab->hash_table[i] = NULL;
+/** Find a prepared name in the table (and the old array while growing) */
+static node_t* lookup (sym_table_t* symTab, const search_key_t* key) {
+  uint32_t mask = symTab->capacity - 1;
+  atomic_thread_fence(memory_order_acquire); /* capacity, then the array */
+  node_t*  node = find_slot(symTab, symTab->slots, mask, key);
+
+  if (node == NULL) {
+    int oldCapacity = symTab->oldCapacity;
+    atomic_thread_fence(memory_order_acquire);
+    slot_t* oldSlots = symTab->oldSlots;
+    if (oldSlots && oldCapacity)
+      node = find_slot(symTab, oldSlots, oldCapacity - 1, key);
   }
- for (int i = 0; i < 65536; i++)
- {
-   symTab->addr_table[i] = NULL;
- }
-  free(x);
-  symTab->size = 0;*/
-   
-     
+  return node;
+}
+
+/** lookup() for readers, which may run while a writer changes the table */
+static node_t* find (sym_table_t* symTab, const search_key_t* key) {
+  unsigned seq;
+  node_t*  node;
+
+  if (! symTab->shared)
+    return lookup(symTab, key);
+
+  do {
+    seq  = read_begin(symTab);
+    node = lookup(symTab, key);
+  } while (read_retry(symTab, seq));
+  return node;
 }
 
 /** @todo implement this function */
 int symbol_add (sym_table_t* symTab, const char* name, int addr) {
-  int index = 0;
-  int hash = 0;
-  
-  node_t * thisOne = symbol_search(symTab, name, &hash, &index);
-  if (thisOne == NULL)
-  {
-    node_t* head = symTab->hash_table[index];
-    
-    node_t* newNode = malloc(sizeof(node_t));
-
-    newNode->next = head;
-    newNode->hash = hash;
-
-    symbol_t* symbol = malloc(sizeof(symbol_t));
-    symbol->addr = addr;
-    symbol->name = strdup(name);
-   
-    newNode->symbol = *symbol;
-  
-    symTab->hash_table[index] = newNode;
-    symTab->addr_table[addr]= newNode->symbol.name;
-
-    symTab->size += 1;
-    free(symbol);
-    return 1;
-  } 
-  return 0;
+  search_key_t key;
+
+  make_key(&key, name);
+  write_begin(symTab);
+  if (lookup(symTab, &key) != NULL) {
+    write_end(symTab);
+    release_key(&key);
+    return 0;
+  }
+
+  if ((symTab->size + 1) * 8 > symTab->capacity * 7)
+    grow(symTab);
+  if (symTab->oldSlots)
+    migrate(symTab, MIGRATE_STEP);
+
+  uint32_t nodeIndex = symTab->size;
+  int      block     = nodeIndex >> NODE_BLOCK_BITS;
+
+  if (block == symTab->numBlocks) {
+    if (block == symTab->maxBlocks) { /* readers may use the old list */
+      int       max    = symTab->maxBlocks ? 2 * symTab->maxBlocks : 8;
+      node_t**  blocks = malloc(max * sizeof(node_t*));
+      if (block)
+        memcpy(blocks, symTab->blocks, block * sizeof(node_t*));
+      retire(symTab, symTab->blocks);
+      symTab->blocks    = blocks;
+      symTab->maxBlocks = max;
+    }
+    symTab->blocks[block] = malloc(NODE_BLOCK * sizeof(node_t));
+    symTab->numBlocks++;
+  }
+
+  /* the name, then the folded name, in one piece of the arena */
+  char*   copy         = arena_alloc(&symTab->names, 2 * (key.len + 1));
+  node_t* newNode      = get_node(symTab, nodeIndex);
+  newNode->hash        = key.hash;
+  newNode->len         = key.len;
+  newNode->folded      = copy + key.len + 1;
+  newNode->symbol.addr = addr;
+  newNode->symbol.name = copy;
+  memcpy(copy, name, key.len + 1);
+  memcpy(copy + key.len + 1, key.folded, key.len + 1);
+
+  atomic_thread_fence(memory_order_release); /* the node before its slot */
+  insert_slot(symTab->slots, symTab->capacity - 1,
+              (slot_t) { key.hash, nodeIndex + 1 });
+  set_label(symTab, addr, newNode->symbol.name);
+  symTab->size += 1;
+  write_end(symTab);
+  release_key(&key);
+  return 1;
 }
 
 /** @todo implement this function */
 struct node* symbol_search (sym_table_t* symTab, const char* name, int* hash, int* index) {
-  *hash = symbol_hash(name);
-  *index = ((*hash) % symTab->capacity); 
-
-  node_t* newNode = symTab->hash_table[*index];
-  
-  while(newNode != NULL)
-  {
-    if(strcasecmp(newNode->symbol.name, name) == 0)
-    {
-      return newNode;
-    }
-   newNode = newNode->next;
-  }
- return NULL;
+  search_key_t   key;
+  node_t* node;
+
+  make_key(&key, name);
+  node   = find(symTab, &key);
+  *hash  = key.hash;
+  *index = key.hash & (symTab->capacity - 1);
+  release_key(&key);
+  return node;
 }
 
 /** @todo implement this function */
 symbol_t* symbol_find_by_name (sym_table_t* symTab, const char* name) {
   int hash = 0;
   int index = 0;
-  node_t* newNode = symbol_search(symTab, name, &hash, &index);
-  if(newNode == NULL)
-  {
-    return NULL;
-  }
-  else
-  {
-    return &(newNode->symbol);
-  }
-  return NULL;
+  node_t* node = symbol_search(symTab, name, &hash, &index);
+
+  return node ? &node->symbol : NULL;
 }
 
 /** @todo implement this function */
 char* symbol_find_by_addr (sym_table_t* symTab, int addr) {
-  if (symTab->addr_table[addr] == 0)
-  {
+  unsigned seq = 0;
+  char*    label;
+
+  if ((addr < 0) || (addr >= LC3_MEMORY_SIZE))
     return NULL;
+
+  do {
+    if (symTab->shared)
+      seq = read_begin(symTab);
+    char** page = symTab->addr_table[addr >> ADDR_PAGE_BITS];
+    label = page ? page[addr & (ADDR_PAGE - 1)] : NULL;
+  } while (symTab->shared && read_retry(symTab, seq));
+  return label;
+}
+
+/** @todo implement this function */
+static void iterate (sym_table_t* symTab, iterate_fnc_t fnc, void* data) {
+  for (int i = 0; i < symTab->capacity; i++) {
+    if (symTab->slots[i].node)
+      (*fnc)(&get_node(symTab, symTab->slots[i].node - 1)->symbol, data);
+  }
+
+  /* entries not yet moved out of the old array */
+  for (int i = symTab->migrated; i < symTab->oldCapacity; i++) {
+    if (symTab->oldSlots[i].node)
+      (*fnc)(&get_node(symTab, symTab->oldSlots[i].node - 1)->symbol, data);
   }
-  return symTab->addr_table[addr];
 }
 
 /** @todo implement this function */
 void symbol_iterate (sym_table_t* symTab, iterate_fnc_t fnc, void* data) {
- for (int i = 0; i < symTab->capacity;i++)
- {
-   node_t* thisOne = symTab->hash_table[i];
-   while(thisOne != NULL)
-   {
-     (*fnc)(&thisOne->symbol, data);
-     thisOne = thisOne->next;
-   }
- }
+  lock_table(symTab);
+  iterate(symTab, fnc, data);
+  unlock_table(symTab);
 }
 
 /** @todo implement this function */
@@ -218,71 +693,195 @@ int compare_names (const void* vp1, const void* vp2) {
   symbol_t* sym1 = *((symbol_t**) vp1);
   symbol_t* sym2 = *((symbol_t**) vp2); // study qsort to understand this
 
-  //printf("%s\n",sym2->name);
-  //fflush(stdin);
-  
-  /*if (j > x)
-    return 1;
-  else if (x > j)
-    return -1;
-  else */
-    return (sym1->name - sym2->name);
+  return strcasecmp(sym1->name, sym2->name);
 }
 
 /** @todo implement this function */
 int compare_addresses (const void* vp1, const void* vp2) {
   symbol_t* sym1 = *((symbol_t**) vp1);
   symbol_t* sym2 = *((symbol_t**) vp2);
-  int final = 0;
-  if (sym1->addr > sym2->addr)
-  {
-    final = 1;
-  }
-  if (sym1->addr < sym2->addr)
-  {
-    final = -1;
+
+  if (sym1->addr != sym2->addr)
+    return (sym1->addr > sym2->addr) ? 1 : -1;
+
+  return compare_names(vp1, vp2);
+}
+
+/** callback used by symbol_view() to fill the list in hash table order */
+static void add_to_list (symbol_t* sym, void* data) {
+  symbol_t*** next = data;
+  *(*next)++ = sym;
+}
+
+/** Make sure a view has room for every symbol (and the terminating NULL) */
+static void view_reserve (view_t* view, int size) {
+  if (view->capacity < size + 1) {
+    view->capacity = 2 * (size + 1);
+    view->list     = realloc(view->list, view->capacity * sizeof(symbol_t*));
   }
-  if (final == 0)
-  {
-    final = compare_names(vp1, vp2);
+}
+
+/** Bring the name ordered list up to date: sort the symbols added since it
+ *  was last updated, then merge them in from the back
+ */
+static void update_names (sym_table_t* symTab) {
+  view_t* view  = &symTab->views[NAME];
+  int     old   = view->count;
+  int     added = symTab->size - old;
+
+  if (added <= 0)
+    return;
+
+  symbol_t** tmp = malloc(added * sizeof(symbol_t*));
+  for (int i = 0; i < added; i++)
+    tmp[i] = &get_node(symTab, old + i)->symbol;
+  qsort(tmp, added, sizeof(symbol_t*), compare_names);
+
+  view_reserve(view, symTab->size);
+  int i = old - 1, j = added - 1, k = symTab->size - 1;
+  while (j >= 0) {
+    if ((i >= 0) && (compare_names(&view->list[i], &tmp[j]) > 0))
+      view->list[k--] = view->list[i--];
+    else
+      view->list[k--] = tmp[j--];
   }
-  return final;
+  free(tmp);
+
+  view->count = symTab->size;
+  view->list[view->count] = NULL;
 }
 
-/** @todo implement this function */
-symbol_t** symbol_order (sym_table_t* symTab, int order) 
-{
-  
-  // will call qsort with either compare_names or compare_addresses
-  symbol_t** x = calloc(symTab->size, sizeof(symbol_t));
-  int current = 0;
-  for (int i = 0; i < (symTab->capacity); i++)
-  {
-     node_t* thisOne = symTab->hash_table[i];
-     while(thisOne != NULL)
-     {
-      x[current] = &(thisOne->symbol);
-      current++;
-      thisOne = thisOne->next;
-     }
+/** Rebuild the address ordered list from the name ordered list */
+static void update_addrs (sym_table_t* symTab) {
+  view_t*    view  = &symTab->views[ADDR];
+  view_t*    names = &symTab->views[NAME];
+  int        size  = symTab->size;
+  bool       radix = true;
+
+  update_names(symTab);
+  view_reserve(view, size);
+
+  for (int i = 0; i < size; i++)
+    radix &= (names->list[i]->addr >= 0) && (names->list[i]->addr <= 0xFFFF);
+
+  if (radix) { /* LSD radix sort, low byte then high byte */
+    symbol_t** tmp = malloc((size + 1) * sizeof(symbol_t*));
+    symbol_t** src = names->list;
+
+    for (int shift = 0; shift < 16; shift += 8) {
+      symbol_t** dst = (shift == 0) ? tmp : view->list;
+      int        count[257] = { 0 };
+
+      for (int i = 0; i < size; i++)
+        count[((src[i]->addr >> shift) & 0xFF) + 1]++;
+      for (int b = 0; b < 256; b++)
+        count[b + 1] += count[b];
+      for (int i = 0; i < size; i++)
+        dst[count[(src[i]->addr >> shift) & 0xFF]++] = src[i];
+      src = dst;
+    }
+    free(tmp);
+  }
+  else { /* addresses outside the LC3 memory, fall back to a compare sort */
+    memcpy(view->list, names->list, size * sizeof(symbol_t*));
+    qsort(view->list, size, sizeof(symbol_t*), compare_addresses);
   }
 
-  if (order == 0)
-  {
-    //symbol_iterate(symTab, symbol_hash, 0);
+  view->count = size;
+  view->list[size] = NULL;
+}
+
+/** symbol_view() without the lock */
+static symbol_t* const* get_view (sym_table_t* symTab, int order) {
+  view_t* view;
+
+  if ((order != NAME) && (order != ADDR))
+    order = HASH;
+  view = &symTab->views[order];
+
+  if (view->count != symTab->size) {
+    if (order == NAME)
+      update_names(symTab);
+    else if (order == ADDR)
+      update_addrs(symTab);
+    else {
+      symbol_t** next;
+      view_reserve(view, symTab->size);
+      next = view->list;
+      iterate(symTab, add_to_list, &next);
+      *next       = NULL;
+      view->count = symTab->size;
+    }
+  }
+  else if (view->list == NULL) { /* empty table */
+    view_reserve(view, 0);
+    view->list[0] = NULL;
   }
-  else if (order == 1)
-  {
-    printf("%s\n",x[0]->name);
-    fflush(stdin);
-    qsort(x, symTab->size, sizeof(symbol_t), compare_names);
+
+  return view->list;
+}
+
+symbol_t* const* symbol_view (sym_table_t* symTab, int order) {
+  lock_table(symTab);
+  symbol_t* const* view = get_view(symTab, order);
+  unlock_table(symTab);
+  return view;
+}
+
+/** Compare a name to a prefix
+ *  @return 0 if the name starts with the prefix, otherwise the order of
+ *  the name relative to the names that do (as in compare_names())
+ */
+static int compare_prefix (const node_t* node, const search_key_t* key) {
+  size_t len = ((size_t) node->len < key->len) ? (size_t) node->len : key->len;
+  int    cmp = memcmp(node->folded, key->folded, len);
+
+  if (cmp != 0)
+    return cmp;
+  return ((size_t) node->len < key->len) ? -1 : 0;
+}
+
+int symbol_find_by_prefix (sym_table_t* symTab, const char* prefix,
+                           symbol_t* const** first) {
+  search_key_t key;
+
+  make_key(&key, prefix);
+  lock_table(symTab);
+
+  symbol_t* const* list = get_view(symTab, NAME);
+  int lo = 0, hi = symTab->size;
+
+  while (lo < hi) { /* first name >= prefix */
+    int mid = lo + (hi - lo) / 2;
+    if (compare_prefix(symbol_node(list[mid]), &key) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
-  else 
-  {
-    //qsort(x, symTab->size, sizeof(symbol_t), compare_addresses);
+
+  int start = lo;
+  hi = symTab->size;
+  while (lo < hi) { /* first name past the ones starting with prefix */
+    int mid = lo + (hi - lo) / 2;
+    if (compare_prefix(symbol_node(list[mid]), &key) <= 0)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
 
-  return x;
-  
+  unlock_table(symTab);
+  release_key(&key);
+  *first = list + start;
+  return lo - start;
 }
 
+/** @todo implement this function */
+symbol_t** symbol_order (sym_table_t* symTab, int order) {
+  lock_table(symTab);
+  symbol_t* const* view = get_view(symTab, order);
+  symbol_t**       list = malloc((symTab->size + 1) * sizeof(symbol_t*));
+
+  memcpy(list, view, (symTab->size + 1) * sizeof(symbol_t*));
+  unlock_table(symTab);
+  return list;
+}
@@ -97,6 +97,23 @@ symbol_t* symbol_find_by_name (sym_table_t* symTab, const char* name);
  */ 
 sym_table_t* symbol_init (int capacity);
 
+/** Create a symbol table that may be used by several threads at once. It
+ *  is used through the same functions as a table made by
+ *  <code>symbol_init()</code>. The find functions and
+ *  <code>symbol_size()</code> take no lock and may run in any number of
+ *  threads while another thread adds symbols; adds and resets are
+ *  serialized. <code>symbol_iterate()</code>, <code>symbol_order()</code>
+ *  and <code>symbol_view()</code> take the writer lock, so the callback of
+ *  <code>symbol_iterate()</code> must not add symbols, and a list returned by
+ *  <code>symbol_view()</code> is only safe to use while no thread adds.
+ *  A <code>symbol_t*</code> that has been found stays valid until the table
+ *  is reset or terminated. <code>symbol_term()</code> must not be called
+ *  while other threads use the table.
+ *  @param capacity - the size of the hash table.
+ *  @return a pointer to the symbol table.
+ */
+sym_table_t* symbol_init_shared (int capacity);
+
 /** Remove all the symbols from the symbol table. After this call the opaque
  *  symbol table pointer is still valid and new symbols may be added to it. 
  *  If needed, clear the <code>addr_table</code>.
@@ -188,5 +205,30 @@ int symbol_size (sym_table_t* symTab);
  */ 
 symbol_t** symbol_order (sym_table_t* symTab, int order);
 
+/** Return the same ordered list as <code>symbol_order()</code>, without
+ *  copying it. The list belongs to the symbol table: the caller must not
+ *  modify or <code>free()</code> it, and it is only valid until the next
+ *  call that changes the table (add, reset or term). Repeated calls on an
+ *  unchanged table are free, and after symbols are added only the new
+ *  symbols are sorted.
+ *  @param symTab - pointer to the symbol table
+ *  @param order - defines the sorting order for the list (HASH, NAME, ADDR)
+ *  @return a NULL terminated array of <code>symbol_t*</code>
+ */
+symbol_t* const* symbol_view (sym_table_t* symTab, int order);
+
+/** Find the symbols whose names start with a prefix (case insensitive).
+ *  The matches are a range of the list <code>symbol_view(symTab, NAME)</code>
+ *  returns, found with a binary search, so the cost depends on the length of
+ *  the prefix and the number of matches, not on the size of the table.
+ *  @param symTab - pointer to the symbol table
+ *  @param prefix - the start of the names (may be empty)
+ *  @param first - set to the first match, in alphabetical order. The list
+ *  is only valid until the table changes, as for <code>symbol_view()</code>.
+ *  @return the number of matches
+ */
+int symbol_find_by_prefix (sym_table_t* symTab, const char* prefix,
+                           symbol_t* const** first);
+
 #endif /* __SYMBOL_H__ */
 
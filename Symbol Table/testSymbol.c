@@ -24,9 +24,15 @@
  *
  */
 
+#define _POSIX_C_SOURCE 200809L /* clock_gettime() */
+
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <time.h>
 
 #include "Debug.h"
 #include "symbol.h"
@@ -60,6 +66,8 @@ static void help() {
   puts("init capacity    - create symbol table with given capacity");
   puts("                     MUST be first action taken");
   puts("add name address - prints 1 on succeses, 0 on failure");
+  puts("bench [size]     - time the symbol table functions with size");
+  puts("                     generated labels (default 1K, 100K and 1M)");
   puts("count            - prints count of names/addresses");
   puts("                     uses function pointers");
   puts("debug level      - turn debug on/off (0 is off)");
@@ -71,6 +79,7 @@ static void help() {
   puts("order option     - calls symbol_order and print value(s)");
   puts("                 - option is HASH|NAME|ADDR");
   puts("search name      - prints NULL or name/address and hash/index");
+  puts("search prefix*   - prints the names/addresses starting with prefix");
   puts("size             - call symbol_size()");
   puts("reset            - call symbol_reset()\n");
 }
@@ -131,6 +140,119 @@ static void printList (sym_table_t* symTab, int order) {
   }
 }
 
+/** number of lookups timed by bench, at least */
+#define BENCH_LOOKUPS 1000000
+
+/** Return a time in nanoseconds */
+static double nanoseconds (void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** xorshift random numbers, so each run looks up the same names */
+static uint32_t benchRandom (uint32_t* seed) {
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 17;
+  *seed ^= *seed << 5;
+  return *seed;
+}
+
+/** Make a label the way LC-3 programs name them: a routine or data
+ *  prefix, in upper or mixed case, and a number to make it unique
+ */
+static void benchName (char* buf, int i, const char* tag) {
+  static const char* words[] = {
+    "LOOP", "Done", "END", "Test_", "GETC_", "OUT_", "PUTS_", "SAVE_R",
+    "Str", "Msg_", "NEXT", "ELSE", "FOR_", "while_", "RET_", "Count",
+    "Stack_", "BUFFER", "Mask", "Array_", "NEG_", "Fn", "Data", "SKIP"
+  };
+  int numWords = sizeof(words) / sizeof(words[0]);
+
+  sprintf(buf, "%s%s%d", words[i % numWords], tag, i / numWords);
+}
+
+/** Print the time per operation since start */
+static void benchReport (const char* what, double start, long ops) {
+  printf("  %-22s %10.1f ns/op\n", what, (nanoseconds() - start) / ops);
+}
+
+/** Time the symbol.h functions on a table of size generated labels */
+static void bench (int size) {
+  char**    names  = malloc(size * sizeof(char*));
+  char**    misses = malloc(size * sizeof(char*));
+  long      lookups = (size > BENCH_LOOKUPS) ? size : BENCH_LOOKUPS;
+  uint32_t  seed   = 2463534242u;
+  long      found  = 0;
+  char      buf[40];
+  double    start;
+  struct rusage usage;
+
+  if (! names || ! misses) {
+    printf("bench: out of memory for %d symbols\n", size);
+    free(names);
+    free(misses);
+    return;
+  }
+
+  for (int i = 0; i < size; i++) {
+    benchName(buf, i, "");
+    names[i] = strdup(buf);
+    benchName(buf, i, "_x");
+    misses[i] = strdup(buf);
+  }
+
+  printf("%d symbols\n", size);
+  sym_table_t* symTab = symbol_init(997);
+
+  start = nanoseconds();
+  for (int i = 0; i < size; i++)
+    symbol_add(symTab, names[i], (0x3000 + 3 * i) & 0xFFFF);
+  benchReport("add", start, size);
+
+  start = nanoseconds();
+  for (long i = 0; i < lookups; i++)
+    found += (symbol_find_by_name(symTab, names[benchRandom(&seed) % size])
+              != NULL);
+  benchReport("find_by_name (hit)", start, lookups);
+
+  start = nanoseconds();
+  for (long i = 0; i < lookups; i++)
+    found += (symbol_find_by_name(symTab, misses[benchRandom(&seed) % size])
+              != NULL);
+  benchReport("find_by_name (miss)", start, lookups);
+
+  start = nanoseconds();
+  for (long i = 0; i < lookups; i++)
+    found += (symbol_find_by_addr(symTab, benchRandom(&seed) & 0xFFFF)
+              != NULL);
+  benchReport("find_by_addr", start, lookups);
+
+  start = nanoseconds();
+  free(symbol_order(symTab, NAME));
+  benchReport("order NAME (per symbol)", start, size);
+
+  start = nanoseconds();
+  free(symbol_order(symTab, ADDR));
+  benchReport("order ADDR (per symbol)", start, size);
+
+  start = nanoseconds();
+  symbol_reset(symTab);
+  benchReport("reset (per symbol)", start, size);
+
+  getrusage(RUSAGE_SELF, &usage);
+  printf("  %-22s %10ld KB\n", "peak RSS", usage.ru_maxrss);
+  debug("%ld lookups succeeded", found);
+
+  symbol_term(symTab);
+  for (int i = 0; i < size; i++) {
+    free(names[i]);
+    free(misses[i]);
+  }
+  free(names);
+  free(misses);
+}
+
 /** Entry point of the program
  * @param argc count of arguments, will always be at least 1
  * @param argv array of parameters to program argv[0] is the name of
@@ -168,6 +290,22 @@ int main (int argc, const char* argv[]) {
     else if (strcmp(cmd, "help") == 0) {
       help();
     }
+    else if (strcmp(cmd, "bench") == 0) {
+      char* tok = strtok(NULL, delim);
+      if (tok) {
+        char* end;
+        long  size = strtol(tok, &end, 0);
+        if ((*end != '\0') || (size < 1) || (size > INT_MAX))
+          printf("bench size must be a number from 1 to %d\n", INT_MAX);
+        else
+          bench((int) size);
+      }
+      else {
+        bench(1000);
+        bench(100000);
+        bench(1000000);
+      }
+    }
     else if (strcmp(cmd, "init") == 0) {
       count  = nextInt();
       symTab = symbol_init(count);
@@ -216,6 +354,16 @@ int main (int argc, const char* argv[]) {
     else if (strcmp(cmd, "search") == 0) {
       int hash, index;
       name              = nextToken();
+      char* star        = strchr(name, '*');
+      if (star && (star[1] == '\0')) {
+        symbol_t* const* first;
+        *star = '\0';
+        count = symbol_find_by_prefix(symTab, name, &first);
+        for (int i = 0; i < count; i++)
+          printResult(first[i], stdout);
+        printf("%d symbols start with '%s'\n", count, name);
+        continue;
+      }
       struct node* node = symbol_search(symTab, name, &hash, &index);
       printf("symbol '%s' hash: %d index: %d is %s in symbol table\n", name,
              hash, index, (node ? "" : "NOT"));